@@ -0,0 +1,202 @@
+-- Microbenchmarks for the stringtable module bindings.
+-- Copy to garrysmod/lua and run "lua_openscript stringtable_benchmark.lua" on a
+-- server with no players, then "stringtable_benchmark [iterations]".
+-- Every write goes to a scratch table created by the script, the engine's own tables
+-- are only read. The scratch table lives until the next level change.
+
+require("stringtable")
+
+local SysTime, format = SysTime, string.format
+
+local sizes = {64, 256, 1024, 4096, 16384}
+local prefix = "stringtable_benchmark/"
+local scratch_name = "stringtable_benchmark"
+local scratch_size = 32768
+
+local function Measure(name, iterations, func, ...)
+	local start = SysTime()
+	for i = 1, iterations do
+		func(i, ...)
+	end
+
+	local elapsed = SysTime() - start
+	MsgN(format("  %-28s %12.1f ns/call", name, elapsed / iterations * 1e9))
+end
+
+local function Fill(tbl, count)
+	local strings = {}
+	for i = 1, count do
+		strings[i] = prefix .. i
+	end
+
+	local indices = tbl:AddStrings(true, strings)
+	local list = {}
+	for i = 1, count do
+		list[#list + 1] = indices[i]
+	end
+
+	return strings, list
+end
+
+local function RunSize(tbl, size, iterations)
+	local available = tbl:GetMaxStrings() - tbl:GetNumStrings()
+	if size > available then
+		MsgN(format("skipping %d entries, only %d slots available", size, available))
+		return false
+	end
+
+	local strings, indices = Fill(tbl, size)
+	local first = indices[1]
+	MsgN(format("%d scratch entries in '%s' (%d strings total)", size, tbl:GetName(), tbl:GetNumStrings()))
+
+	local function Index(i)
+		return indices[(i - 1) % size + 1]
+	end
+
+	local name = tbl:GetName()
+	-- objects are unique per table, __eq only runs when comparing two different ones
+	local other = stringtable.Get(tbl:GetID() == 0 and 1 or 0)
+	Measure("SetName", iterations, function(i) tbl:SetName(i % 2 == 0 and name or prefix .. "renamed") end)
+	tbl:SetName(name)
+	Measure("__index (method lookup)", iterations, function() return tbl.GetName end)
+	Measure("__newindex/__index (field)", iterations, function(i)
+		tbl.benchmark_field = i
+		return tbl.benchmark_field
+	end)
+	tbl.benchmark_field = nil
+	Measure("__eq", iterations, function() return tbl == other end)
+	Measure("__tostring", iterations, function() return tostring(tbl) end)
+	Measure("GetName", iterations, function() tbl:GetName() end)
+	Measure("GetID", iterations, function() tbl:GetID() end)
+	Measure("GetNumStrings", iterations, function() tbl:GetNumStrings() end)
+	Measure("GetMaxStrings", iterations, function() tbl:GetMaxStrings() end)
+	Measure("GetEntryBits", iterations, function() tbl:GetEntryBits() end)
+	Measure("ChangedSinceTick", iterations, function() tbl:ChangedSinceTick(0) end)
+	Measure("GetString", iterations, function(i) tbl:GetString(Index(i)) end)
+	Measure("GetStringUserData", iterations, function(i) tbl:GetStringUserData(Index(i)) end)
+	Measure("FindStringIndex", iterations, function(i) tbl:FindStringIndex(strings[(i - 1) % size + 1]) end)
+	Measure("AddString (existing)", iterations, function(i) tbl:AddString(true, strings[(i - 1) % size + 1]) end)
+	Measure("SetStringUserData", iterations, function(i) tbl:SetStringUserData(Index(i), "userdata" .. i % 16) end)
+	Measure("SetString", iterations, function(i)
+		local k = (i - 1) % size + 1
+		local str = prefix .. "renamed/" .. k
+		if tbl:SetString(indices[k], str) then
+			tbl:SetString(indices[k], strings[k])
+		end
+	end)
+
+	local bulk = math.max(1, math.floor(iterations / size))
+	local userdata = {}
+	for i = 1, size do
+		userdata[i] = "bulk" .. i
+	end
+
+	Measure("AddStrings (existing)", bulk, function() tbl:AddStrings(true, strings) end)
+	local renamed = {}
+	for i = 1, size do
+		renamed[i] = prefix .. "renamed/" .. i
+	end
+
+	Measure("SetStrings (rejected)", bulk, function() tbl:SetStrings(indices, strings) end)
+	-- an even number of calls alternating both lists, so every call writes and the table ends restored
+	Measure("SetStrings (writes)", bulk * 2, function(i) tbl:SetStrings(indices, i % 2 == 1 and renamed or strings) end)
+	Measure("SetStringsUserData", bulk, function() tbl:SetStringsUserData(indices, userdata) end)
+	Measure("CountChangedSince", bulk, function() tbl:CountChangedSince(0) end)
+	Measure("GetChangedSince", bulk, function() tbl:GetChangedSince(0, true) end)
+	Measure("GetTable", bulk, function() tbl:GetTable() end)
+	Measure("GetStrings", bulk, function() tbl:GetStrings() end)
+	Measure("GetStringsUserData", bulk, function() tbl:GetStringsUserData() end)
+	Measure("GetRange", bulk, function() tbl:GetRange(first, size, true) end)
+	Measure("Entries", bulk, function()
+		for _ in tbl:Entries(first, size) do end
+	end)
+
+	tbl:EnableCache(true)
+	Measure("GetString (cached)", iterations, function(i) tbl:GetString(Index(i)) end)
+	Measure("GetStringUserData (cached)", iterations, function(i) tbl:GetStringUserData(Index(i)) end)
+	MsgN(format("  cache hits/misses: %d/%d", tbl:GetCacheStats()))
+	tbl:EnableCache(false)
+
+	-- cache hits compare the whole userdata, so measure it against big entries too
+	local large = {}
+	for i = 1, size do
+		large[i] = string.rep(string.char(i % 256), 8192)
+	end
+
+	tbl:SetStringsUserData(indices, large)
+	Measure("GetStringUserData (8 KiB)", iterations, function(i) tbl:GetStringUserData(Index(i)) end)
+	tbl:EnableCache(true)
+	Measure("GetStringUserData (8 KiB, cached)", iterations, function(i) tbl:GetStringUserData(Index(i)) end)
+	tbl:EnableCache(false)
+
+	local temporary = {}
+	for i = 1, math.min(size, 64) do
+		temporary[i] = prefix .. "temporary/" .. i
+	end
+
+	local added = tbl:AddStrings(true, temporary)
+	local start = SysTime()
+	for i = #temporary, 1, -1 do
+		tbl:DeleteString(added[i])
+	end
+
+	MsgN(format("  %-28s %12.1f ns/call", "DeleteString (tail)", (SysTime() - start) / #temporary * 1e9))
+
+	added = tbl:AddStrings(true, temporary)
+	local list = {}
+	for i = 1, #temporary do
+		list[i] = added[i]
+	end
+
+	start = SysTime()
+	tbl:DeleteStrings(list, true)
+	MsgN(format("  %-28s %12.1f ns/entry", "DeleteStrings (unordered)", (SysTime() - start) / #temporary * 1e9))
+
+	start = SysTime()
+	tbl:DeleteStrings(indices)
+	MsgN(format("  %-28s %12.1f ns/entry", "DeleteStrings (ordered)", (SysTime() - start) / size * 1e9))
+
+	return true
+end
+
+local function RunContainer(iterations)
+	MsgN("stringtable library")
+
+	local names = stringtable.GetNames()
+	local count = stringtable.GetCount()
+	Measure("Find", iterations, function(i) stringtable.Find(names[(i - 1) % count]) end)
+	Measure("Get", iterations, function(i) stringtable.Get((i - 1) % count) end)
+	Measure("GetCount", iterations, function() stringtable.GetCount() end)
+	Measure("GetNames", math.max(1, math.floor(iterations / count)), function() stringtable.GetNames() end)
+end
+
+concommand.Add("stringtable_benchmark", function(ply, cmd, args)
+	if IsValid(ply) then
+		return
+	end
+
+	-- clients that are already connected never get tables created after they joined
+	if player.GetCount() ~= 0 then
+		MsgN("stringtable_benchmark has to run on a server with no players")
+		return
+	end
+
+	local tbl = stringtable.Find(scratch_name)
+	if tbl == nil then
+		local err
+		tbl, err = stringtable.Create(scratch_name, scratch_size)
+		if tbl == nil then
+			MsgN("unable to create the scratch stringtable: " .. err)
+			return
+		end
+	end
+
+	local iterations = tonumber(args[1]) or 100000
+
+	RunContainer(iterations)
+	for _, size in ipairs(sizes) do
+		if not RunSize(tbl, size, iterations) then
+			break
+		end
+	end
+end)
@@ -0,0 +1,165 @@
+#include "batch.hpp"
+#include "stringtable.hpp"
+#include "stringtablecontainer.hpp"
+#include "codec.hpp"
+#include "tasks.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace batch
+{
+
+struct Batch
+{
+	CNetworkStringTable *stringtable;
+	int32_t id;
+	std::map<int32_t, std::string> userdata;
+	int32_t coalesced;
+};
+
+static std::vector<std::unique_ptr<Batch>> batches;
+
+static std::vector<std::unique_ptr<Batch>>::iterator Find( CNetworkStringTable *stable )
+{
+	for( auto it = batches.begin( ); it != batches.end( ); ++it )
+		if( ( *it )->stringtable == stable )
+			return it;
+
+	return batches.end( );
+}
+
+class CommitTask : public tasks::Task
+{
+public:
+	CommitTask( CNetworkStringTable *stable ) :
+		stringtable( stable )
+	{ }
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		auto it = Find( stringtable );
+		if( it == batches.end( ) )
+			return false;
+
+		if( stringtablecontainer::IsAlive( ( *it )->stringtable, ( *it )->id ) )
+		{
+			int32_t coalesced = 0, rejected = 0;
+			Commit( LUA, stringtable, coalesced, rejected );
+		}
+		else
+		{
+			batches.erase( it );
+		}
+
+		return false;
+	}
+
+private:
+	CNetworkStringTable *stringtable;
+};
+
+bool Begin( CNetworkStringTable *stable )
+{
+	if( Find( stable ) != batches.end( ) )
+		return false;
+
+	Batch *batch = new Batch;
+	batch->stringtable = stable;
+	batch->id = stable->GetTableId( );
+	batch->coalesced = 0;
+	batches.emplace_back( batch );
+
+	tasks::Add( new CommitTask( stable ) );
+	return true;
+}
+
+bool Stage( CNetworkStringTable *stable, int32_t index, const char *userdata, size_t length )
+{
+	if( batches.empty( ) )
+		return false;
+
+	auto it = Find( stable );
+	if( it == batches.end( ) )
+		return false;
+
+	Batch &batch = **it;
+	auto result = batch.userdata.emplace( index, std::string( ) );
+	if( !result.second )
+		++batch.coalesced;
+
+	result.first->second.assign( userdata, length );
+	return true;
+}
+
+const std::string *GetStaged( CNetworkStringTable *stable, int32_t index )
+{
+	if( batches.empty( ) )
+		return nullptr;
+
+	auto it = Find( stable );
+	if( it == batches.end( ) )
+		return nullptr;
+
+	auto staged = ( *it )->userdata.find( index );
+	return staged != ( *it )->userdata.end( ) ? &staged->second : nullptr;
+}
+
+int32_t Commit( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stable, int32_t &coalesced, int32_t &rejected )
+{
+	coalesced = 0;
+	rejected = 0;
+	auto it = Find( stable );
+	if( it == batches.end( ) )
+		return 0;
+
+	std::unique_ptr<Batch> batch = std::move( *it );
+	batches.erase( it );
+
+	// ascending order lets WriteUpdate use single bit indices for runs of entries
+	int32_t applied = 0;
+	for( const auto &write : batch->userdata )
+		if( stable->GetString( write.first ) != nullptr )
+		{
+			if( codec::SetStringUserData( stable, write.first, write.second.data( ), static_cast<int32_t>( write.second.size( ) ) ) )
+				++applied;
+			else
+				++rejected;
+		}
+
+	if( applied != 0 )
+		stringtable::Invalidate( LUA, stable );
+
+	coalesced = batch->coalesced;
+	return applied;
+}
+
+void Flush( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stable )
+{
+	if( batches.empty( ) )
+		return;
+
+	int32_t coalesced = 0, rejected = 0;
+	Commit( LUA, stable, coalesced, rejected );
+}
+
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	while( !batches.empty( ) )
+	{
+		CNetworkStringTable *stable = batches.back( )->stringtable;
+		if( stringtablecontainer::IsAlive( stable, batches.back( )->id ) )
+		{
+			int32_t coalesced = 0, rejected = 0;
+			Commit( LUA, stable, coalesced, rejected );
+		}
+		else
+		{
+			batches.pop_back( );
+		}
+	}
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+class CNetworkStringTable;
+
+namespace batch
+{
+
+// Starts staging userdata writes for the table, returns false if it already was.
+// Staged writes are committed by Commit or, at the latest, on the next Think.
+// Userdata readers see staged writes, but GetChangedSince doesn't report them
+// until they're committed. Anything that moves, renames or removes strings
+// flushes the batch first, since staged writes are keyed by index.
+bool Begin( CNetworkStringTable *stringtable );
+
+// Stages a userdata write, replacing any previous one for the same index.
+// Returns false when the table isn't batching and the write should go through.
+bool Stage( CNetworkStringTable *stringtable, int32_t index, const char *userdata, size_t length );
+
+// Staged userdata for an index, nullptr if there is none
+const std::string *GetStaged( CNetworkStringTable *stringtable, int32_t index );
+
+// Applies the staged writes in index order and stops batching. Returns the number of
+// writes applied and, through coalesced, how many staged writes were overwritten and,
+// through rejected, how many didn't fit in their entry once encoded.
+int32_t Commit( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable, int32_t &coalesced, int32_t &rejected );
+
+// Commits the table's batch, if any, and keeps batching off
+void Flush( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable );
+
+// Commits every pending batch
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
+
+}
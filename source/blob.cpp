@@ -0,0 +1,146 @@
+#include "blob.hpp"
+#include "codec.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace blob
+{
+
+struct Manifest
+{
+	uint32_t size;
+	uint32_t chunks;
+};
+
+// leaves room for the codec's tag
+static const size_t chunk_size = CNetworkStringTableItem::MAX_USERDATA_SIZE - 2;
+
+static std::string GetChunkName( const char *name, uint32_t chunk )
+{
+	return std::string( name ) + '#' + std::to_string( chunk );
+}
+
+// Writes userdata unless the entry already holds it, creating the entry if needed
+static bool Write( INetworkStringTable *stable, const char *str, const void *userdata, size_t length,
+	bool is_server, int32_t &written )
+{
+	const int32_t index = stable->FindStringIndex( str );
+	if( index == INVALID_STRING_INDEX )
+	{
+		if( codec::AddString( stable, is_server, str, userdata, static_cast<int32_t>( length ) ) == INVALID_STRING_INDEX )
+			return false;
+
+		++written;
+		return true;
+	}
+
+	std::string buffer;
+	int32_t current_length = 0;
+	const void *current = codec::GetStringUserData( stable, index, current_length, buffer );
+	if( current != nullptr && static_cast<size_t>( current_length ) == length &&
+		std::memcmp( current, userdata, length ) == 0 )
+		return true;
+
+	if( !codec::SetStringUserData( stable, index, userdata, static_cast<int32_t>( length ) ) )
+		return false;
+
+	++written;
+	return true;
+}
+
+static bool ReadManifest( INetworkStringTable *stable, int32_t index, Manifest &manifest, std::string &buffer )
+{
+	int32_t length = 0;
+	const void *userdata = codec::GetStringUserData( stable, index, length, buffer );
+	if( userdata == nullptr || length != sizeof( Manifest ) )
+		return false;
+
+	std::memcpy( &manifest, userdata, sizeof( Manifest ) );
+	return true;
+}
+
+const char *Set( CNetworkStringTable *stable, const char *name, const char *data, size_t length,
+	bool is_server, int32_t &written )
+{
+	written = 0;
+
+	// chunks and the manifest never have the table's fixed length
+	if( stable->m_bUserDataFixedSize )
+		return "stringtable has fixed size userdata";
+
+	Manifest manifest;
+	manifest.size = static_cast<uint32_t>( length );
+	manifest.chunks = static_cast<uint32_t>( ( length + chunk_size - 1 ) / chunk_size );
+
+	// previous chunk count, to clear the ones a smaller blob doesn't use anymore
+	Manifest previous = { 0, 0 };
+	std::string buffer;
+	const int32_t manifest_index = stable->FindStringIndex( name );
+	const bool exists = manifest_index != INVALID_STRING_INDEX;
+	if( exists )
+		ReadManifest( stable, manifest_index, previous, buffer );
+
+	if( stable->GetNumStrings( ) + ( exists ? 0 : 1 ) + static_cast<int32_t>( manifest.chunks ) -
+		static_cast<int32_t>( std::min( previous.chunks, manifest.chunks ) ) > stable->GetMaxStrings( ) )
+		return "not enough free entries";
+
+	// a new manifest goes first so the chunks follow it and get consecutive indices
+	if( !exists && stable->AddString( is_server, name ) == INVALID_STRING_INDEX )
+		return "unable to add manifest entry";
+
+	for( uint32_t chunk = 0; chunk < manifest.chunks; ++chunk )
+	{
+		const size_t offset = chunk * chunk_size;
+		const size_t size = std::min( chunk_size, length - offset );
+		if( !Write( stable, GetChunkName( name, chunk ).c_str( ), data + offset, size, is_server, written ) )
+			return "unable to write chunk entry";
+	}
+
+	for( uint32_t chunk = manifest.chunks; chunk < previous.chunks; ++chunk )
+	{
+		const int32_t index = stable->FindStringIndex( GetChunkName( name, chunk ).c_str( ) );
+		if( index != INVALID_STRING_INDEX && stable->GetStringUserData( index, nullptr ) != nullptr )
+		{
+			stable->SetStringUserData( index, 0, nullptr );
+			++written;
+		}
+	}
+
+	// the manifest is updated last, readers never see it ahead of its chunks
+	if( !Write( stable, name, &manifest, sizeof( manifest ), is_server, written ) )
+		return "unable to write manifest entry";
+
+	return nullptr;
+}
+
+bool Get( INetworkStringTable *stable, const char *name, std::string &data )
+{
+	std::string buffer;
+	Manifest manifest;
+	const int32_t manifest_index = stable->FindStringIndex( name );
+	if( manifest_index == INVALID_STRING_INDEX || !ReadManifest( stable, manifest_index, manifest, buffer ) )
+		return false;
+
+	data.clear( );
+	data.reserve( manifest.size );
+	for( uint32_t chunk = 0; chunk < manifest.chunks; ++chunk )
+	{
+		const int32_t index = stable->FindStringIndex( GetChunkName( name, chunk ).c_str( ) );
+		if( index == INVALID_STRING_INDEX )
+			return false;
+
+		int32_t length = 0;
+		const void *userdata = codec::GetStringUserData( stable, index, length, buffer );
+		if( userdata == nullptr )
+			return false;
+
+		data.append( static_cast<const char *>( userdata ), static_cast<size_t>( length ) );
+	}
+
+	return data.size( ) == manifest.size;
+}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class INetworkStringTable;
+class CNetworkStringTable;
+
+namespace blob
+{
+
+// Stores data under name as a manifest entry (total size and chunk count) followed by
+// "name#0", "name#1"... chunk entries. Chunks whose userdata didn't change aren't written,
+// so only they are networked again. Returns nullptr on success, written is the number of
+// entries that were changed. Tables with fixed size userdata can't hold blobs.
+const char *Set( CNetworkStringTable *stringtable, const char *name, const char *data, size_t length,
+	bool is_server, int32_t &written );
+
+// Reassembles a blob, returns false if it's missing or incomplete
+bool Get( INetworkStringTable *stringtable, const char *name, std::string &data );
+
+}
@@ -0,0 +1,263 @@
+#include "changes.hpp"
+#include "stringtable.hpp"
+#include "stringtablecontainer.hpp"
+#include "tasks.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <tier0/dbg.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#if defined _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <dlfcn.h>
+#endif
+
+namespace changes
+{
+
+struct Subscription
+{
+	CNetworkStringTable *stringtable;
+	int32_t id;
+	pfnStringChanged previous_function;
+	void *previous_object;
+	std::vector<int32_t> callbacks;
+	std::vector<int32_t> pending;
+	bool detached;
+};
+
+static std::vector<std::unique_ptr<Subscription>> subscriptions;
+static bool dispatching = false;
+
+static void StringChanged( void *object, INetworkStringTable *stable, int index, const char *str, const void *data )
+{
+	Subscription *subscription = static_cast<Subscription *>( object );
+	if( subscription->previous_function != nullptr )
+		subscription->previous_function( subscription->previous_object, stable, index, str, data );
+
+	if( !subscription->callbacks.empty( ) )
+		subscription->pending.push_back( index );
+}
+
+static bool IsAlive( const Subscription &subscription )
+{
+	return stringtablecontainer::IsAlive( subscription.stringtable, subscription.id );
+}
+
+static void FreeCallbacks( GarrysMod::Lua::ILuaBase *LUA, Subscription &subscription )
+{
+	for( int32_t reference : subscription.callbacks )
+		LUA->ReferenceFree( reference );
+
+	subscription.callbacks.clear( );
+	subscription.pending.clear( );
+}
+
+static void Detach( Subscription &subscription )
+{
+	CNetworkStringTable *stable = subscription.stringtable;
+	if( stable->m_changeFunc != StringChanged || stable->m_pObject != &subscription )
+	{
+		// someone chained on top of us, keep forwarding to the previous callback
+		Warning( "[stringtable] unable to unhook change callback of '%s'\n", stable->GetTableName( ) );
+		return;
+	}
+
+	stable->SetStringChangedCallback( subscription.previous_object, subscription.previous_function );
+	subscription.detached = true;
+}
+
+// Keeps this module loaded for the rest of the process, for callbacks that other code
+// chained on top of ours and that we can't take back
+static bool PinModule( )
+{
+#if defined _WIN32
+	HMODULE module = nullptr;
+	return GetModuleHandleExA(
+		GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+		reinterpret_cast<LPCSTR>( &StringChanged ),
+		&module
+	) != 0;
+#else
+	Dl_info info;
+	if( dladdr( reinterpret_cast<void *>( &StringChanged ), &info ) == 0 || info.dli_fname == nullptr )
+		return false;
+
+	// the extra reference is never closed, RTLD_NODELETE keeps the code mapped regardless
+	return dlopen( info.dli_fname, RTLD_NOW | RTLD_NOLOAD | RTLD_NODELETE ) != nullptr;
+#endif
+}
+
+static Subscription *Find( CNetworkStringTable *stable )
+{
+	for( auto &subscription : subscriptions )
+		if( subscription->stringtable == stable && !subscription->detached && IsAlive( *subscription ) )
+			return subscription.get( );
+
+	return nullptr;
+}
+
+static void Deliver( GarrysMod::Lua::ILuaBase *LUA, Subscription &subscription )
+{
+	std::vector<int32_t> indices;
+	indices.swap( subscription.pending );
+	std::sort( indices.begin( ), indices.end( ) );
+	indices.erase( std::unique( indices.begin( ), indices.end( ) ), indices.end( ) );
+
+	stringtable::Push( LUA, subscription.stringtable );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < indices.size( ); ++k )
+	{
+		LUA->PushNumber( static_cast<double>( k + 1 ) );
+		LUA->PushNumber( indices[k] );
+		LUA->SetTable( -3 );
+	}
+
+	// callbacks can unsubscribe (clearing the list) or subscribe again while we're iterating
+	for( size_t k = 0; k < subscription.callbacks.size( ); ++k )
+	{
+		LUA->ReferencePush( subscription.callbacks[k] );
+		LUA->Push( -3 );
+		LUA->Push( -3 );
+		tasks::Call( LUA, 2 );
+	}
+
+	LUA->Pop( 2 );
+}
+
+class DispatchTask : public tasks::Task
+{
+public:
+	DispatchTask( )
+	{
+		dispatching = true;
+	}
+
+	~DispatchTask( )
+	{
+		dispatching = false;
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		for( size_t k = 0; k < subscriptions.size( ); )
+		{
+			Subscription &subscription = *subscriptions[k];
+			if( !subscription.detached && !IsAlive( subscription ) )
+			{
+				// the engine freed the table (level change), its callback went with it
+				FreeCallbacks( LUA, subscription );
+				subscription.detached = true;
+			}
+
+			if( !subscription.detached && !subscription.pending.empty( ) )
+				Deliver( LUA, subscription );
+
+			if( subscriptions[k]->detached )
+				subscriptions.erase( subscriptions.begin( ) + k );
+			else
+				++k;
+		}
+
+		return std::any_of( subscriptions.begin( ), subscriptions.end( ), []( const std::unique_ptr<Subscription> &subscription )
+		{
+			return !subscription->callbacks.empty( );
+		} );
+	}
+};
+
+void Subscribe( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stable, int32_t callback )
+{
+	Subscription *subscription = Find( stable );
+	if( subscription == nullptr )
+	{
+		subscription = new Subscription;
+		subscription->stringtable = stable;
+		subscription->id = stable->GetTableId( );
+		subscription->previous_function = stable->m_changeFunc;
+		subscription->previous_object = stable->m_pObject;
+		subscription->detached = false;
+		subscriptions.emplace_back( subscription );
+
+		stable->SetStringChangedCallback( subscription, StringChanged );
+	}
+
+	subscription->callbacks.push_back( callback );
+
+	if( !dispatching )
+		tasks::Add( new DispatchTask );
+}
+
+bool Unsubscribe( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stable )
+{
+	Subscription *subscription = Find( stable );
+	if( subscription == nullptr || subscription->callbacks.empty( ) )
+		return false;
+
+	FreeCallbacks( LUA, *subscription );
+	Detach( *subscription );
+	return true;
+}
+
+void Notify( CNetworkStringTable *stable, int32_t index )
+{
+	Notify( stable, index, index + 1 );
+}
+
+void Notify( CNetworkStringTable *stable, int32_t start, int32_t end )
+{
+	if( subscriptions.empty( ) || start >= end )
+		return;
+
+	Subscription *subscription = Find( stable );
+	if( subscription == nullptr || subscription->callbacks.empty( ) )
+		return;
+
+	for( int32_t k = start; k < end; ++k )
+		subscription->pending.push_back( k );
+}
+
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	for( auto &subscription : subscriptions )
+	{
+		if( subscription->detached )
+			continue;
+
+		FreeCallbacks( LUA, *subscription );
+		if( IsAlive( *subscription ) )
+			Detach( *subscription );
+	}
+
+	// the ones we couldn't unhook are still called through, so neither they nor our
+	// code can go away
+	bool pinned = false;
+	for( auto &subscription : subscriptions )
+	{
+		if( subscription->detached || !IsAlive( *subscription ) )
+			continue;
+
+		if( !pinned && !( pinned = PinModule( ) ) )
+		{
+			// last resort, whoever chained on top of us loses their callback instead of crashing
+			Warning( "[stringtable] unable to keep module loaded, dropping change callbacks chained after ours\n" );
+			CNetworkStringTable *stable = subscription->stringtable;
+			stable->SetStringChangedCallback( subscription->previous_object, subscription->previous_function );
+			subscription->detached = true;
+			continue;
+		}
+
+		subscription.release( );
+	}
+
+	subscriptions.clear( );
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+class CNetworkStringTable;
+
+namespace changes
+{
+
+// Hooks the table's change callback (chaining the existing one) and calls callback once per
+// frame with the table and the sorted indices that changed since the last call.
+// callback is a registry reference owned by this module from now on.
+void Subscribe( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable, int32_t callback );
+
+// Frees every subscriber of the table and restores its previous change callback
+bool Unsubscribe( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable );
+
+// Reports changes made without going through the engine (and so its change callback)
+void Notify( CNetworkStringTable *stringtable, int32_t index );
+void Notify( CNetworkStringTable *stringtable, int32_t start, int32_t end );
+
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
+
+}
@@ -0,0 +1,232 @@
+#include "codec.hpp"
+#include "stringtablecontainer.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <tier1/lzss.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace codec
+{
+
+// Every encoded userdata starts with one of these
+enum Tag : uint8_t
+{
+	TagRaw = 0,
+	TagLZSS = 1
+};
+
+// Decoded userdata bigger than this is rejected, it may come from the network
+static const uint32_t max_decoded_size = 1024 * 1024;
+
+// Userdata bigger than this, encoded or not, can't be networked
+static const size_t max_userdata_size = CNetworkStringTableItem::MAX_USERDATA_SIZE - 1;
+
+struct Table
+{
+	INetworkStringTable *stringtable;
+	int32_t id;
+};
+
+static std::vector<Table> enabled;
+
+static std::vector<Table>::iterator Find( INetworkStringTable *stable )
+{
+	return std::find_if( enabled.begin( ), enabled.end( ), [stable]( const Table &table )
+	{
+		return table.stringtable == stable;
+	} );
+}
+
+bool Enable( CNetworkStringTable *stable, bool enable )
+{
+	if( enable && stable->m_bUserDataFixedSize )
+		return false;
+
+	enabled.erase( std::remove_if( enabled.begin( ), enabled.end( ), []( const Table &table )
+	{
+		return !stringtablecontainer::IsAlive( table.stringtable, table.id );
+	} ), enabled.end( ) );
+
+	auto it = Find( stable );
+	if( enable && it == enabled.end( ) )
+		enabled.push_back( { stable, stable->GetTableId( ) } );
+	else if( !enable && it != enabled.end( ) )
+		enabled.erase( it );
+
+	return true;
+}
+
+bool IsEnabled( INetworkStringTable *stable )
+{
+	if( enabled.empty( ) )
+		return false;
+
+	auto it = Find( stable );
+	// tables recreated on level change must not inherit the codec through a reused address
+	return it != enabled.end( ) && stringtablecontainer::IsAlive( it->stringtable, it->id );
+}
+
+// LZSS when it saves anything, raw otherwise
+static void Encode( const void *userdata, int32_t length, std::string &buffer )
+{
+	buffer.resize( static_cast<size_t>( length ) + 1 );
+
+	unsigned int compressed = 0;
+	CLZSS lzss;
+	if( length > 0 && lzss.CompressNoAlloc( static_cast<const unsigned char *>( userdata ), length,
+		reinterpret_cast<unsigned char *>( &buffer[1] ), &compressed ) != nullptr )
+	{
+		buffer[0] = static_cast<char>( TagLZSS );
+		buffer.resize( compressed + 1 );
+		return;
+	}
+
+	buffer[0] = static_cast<char>( TagRaw );
+	if( length > 0 )
+		buffer.replace( 1, std::string::npos, static_cast<const char *>( userdata ), static_cast<size_t>( length ) );
+}
+
+// CLZSS::Uncompress, bounded by both the input and the output. CLZSS::SafeUncompress only
+// bounds the output and this data can come from the network.
+static bool Decode( const unsigned char *input, size_t input_length, uint32_t size, std::string &buffer )
+{
+	buffer.resize( size );
+	unsigned char *output = reinterpret_cast<unsigned char *>( &buffer[0] );
+	const unsigned char *end = input + input_length;
+	uint32_t written = 0;
+	uint32_t command = 0;
+	int32_t pending = 0;
+	for( ;; )
+	{
+		if( pending == 0 )
+		{
+			if( input == end )
+				return false;
+
+			command = *input++;
+			pending = 8;
+		}
+
+		--pending;
+		const bool reference = ( command & 0x01 ) != 0;
+		command >>= 1;
+
+		if( !reference )
+		{
+			if( input == end || written == size )
+				return false;
+
+			output[written++] = *input++;
+			continue;
+		}
+
+		if( end - input < 2 )
+			return false;
+
+		const uint32_t position = ( static_cast<uint32_t>( input[0] ) << LZSS_LOOKSHIFT ) | ( input[1] >> LZSS_LOOKSHIFT );
+		const uint32_t count = ( input[1] & 0x0F ) + 1u;
+		input += 2;
+		if( count == 1 )
+			return written == size;
+
+		if( position + 1 > written || count > size - written )
+			return false;
+
+		// byte by byte, the source can overlap what's being written
+		const unsigned char *source = output + written - position - 1;
+		for( uint32_t k = 0; k < count; ++k )
+			output[written++] = source[k];
+	}
+}
+
+bool Fits( INetworkStringTable *stable, const void *userdata, int32_t length )
+{
+	// encoding adds the tag byte at most, only try compressing when that doesn't fit
+	const bool enabled = IsEnabled( stable );
+	if( static_cast<size_t>( length ) + ( enabled ? 1 : 0 ) <= max_userdata_size )
+		return true;
+
+	if( !enabled )
+		return false;
+
+	std::string buffer;
+	Encode( userdata, length, buffer );
+	return buffer.size( ) <= max_userdata_size;
+}
+
+bool SetStringUserData( INetworkStringTable *stable, int32_t index, const void *userdata, int32_t length )
+{
+	if( !IsEnabled( stable ) )
+	{
+		if( static_cast<size_t>( length ) > max_userdata_size )
+			return false;
+
+		stable->SetStringUserData( index, length, userdata );
+		return true;
+	}
+
+	std::string buffer;
+	Encode( userdata, length, buffer );
+	if( buffer.size( ) > max_userdata_size )
+		return false;
+
+	stable->SetStringUserData( index, static_cast<int32_t>( buffer.size( ) ), buffer.data( ) );
+	return true;
+}
+
+int32_t AddString( INetworkStringTable *stable, bool is_server, const char *str, const void *userdata, int32_t length )
+{
+	if( !IsEnabled( stable ) )
+	{
+		if( static_cast<size_t>( length ) > max_userdata_size )
+			return INVALID_STRING_INDEX;
+
+		return stable->AddString( is_server, str, length, userdata );
+	}
+
+	std::string buffer;
+	Encode( userdata, length, buffer );
+	if( buffer.size( ) > max_userdata_size )
+		return INVALID_STRING_INDEX;
+
+	return stable->AddString( is_server, str, static_cast<int32_t>( buffer.size( ) ), buffer.data( ) );
+}
+
+const void *GetStringUserData( INetworkStringTable *stable, int32_t index, int32_t &length, std::string &buffer )
+{
+	length = 0;
+	const unsigned char *userdata = static_cast<const unsigned char *>( stable->GetStringUserData( index, &length ) );
+	if( userdata == nullptr || !IsEnabled( stable ) )
+		return userdata;
+
+	if( length < 1 )
+		return nullptr;
+
+	if( userdata[0] == TagRaw )
+	{
+		length -= 1;
+		return userdata + 1;
+	}
+
+	// the header is read before anything else, it has to be there
+	if( userdata[0] != TagLZSS || static_cast<size_t>( length ) < 1 + sizeof( lzss_header_t ) ||
+		!CLZSS::IsCompressed( userdata + 1 ) )
+		return nullptr;
+
+	const uint32_t size = CLZSS::GetActualSize( userdata + 1 );
+	if( size > max_decoded_size ||
+		!Decode( userdata + 1 + sizeof( lzss_header_t ), static_cast<size_t>( length ) - 1 - sizeof( lzss_header_t ), size, buffer ) )
+		return nullptr;
+
+	length = static_cast<int32_t>( size );
+	return buffer.data( );
+}
+
+void Deinitialize( )
+{
+	enabled.clear( );
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class INetworkStringTable;
+class CNetworkStringTable;
+
+namespace codec
+{
+
+// Opt-in per table userdata compression. Both realms have to enable it on a table to
+// decode its userdata, entries written before enabling it are not readable through it.
+// Tables with fixed size userdata can't be encoded, enabling fails on them.
+bool Enable( CNetworkStringTable *stringtable, bool enable );
+bool IsEnabled( INetworkStringTable *stringtable );
+
+// Whether SetStringUserData would accept the userdata
+bool Fits( INetworkStringTable *stringtable, const void *userdata, int32_t length );
+
+// Writes userdata through the table's codec, if any. Fails, without writing anything,
+// when the (encoded) userdata doesn't fit in an entry.
+bool SetStringUserData( INetworkStringTable *stringtable, int32_t index, const void *userdata, int32_t length );
+int32_t AddString( INetworkStringTable *stringtable, bool is_server, const char *str, const void *userdata, int32_t length );
+
+// Returns the userdata as it was written, decoding into buffer when needed.
+// Returns nullptr when the entry has no userdata or it fails to decode.
+const void *GetStringUserData( INetworkStringTable *stringtable, int32_t index, int32_t &length, std::string &buffer );
+
+// Disables the codec on every table
+void Deinitialize( );
+
+}
@@ -0,0 +1,403 @@
+#include "dumpfile.hpp"
+#include "stringtablecontainer.hpp"
+#include "stringtablefile.hpp"
+#include "tasks.hpp"
+#include "codec.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <GarrysMod/InterfacePointers.hpp>
+#include <filesystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace dumpfile
+{
+
+static const char path_id[] = "DATA";
+static const int32_t default_budget_us = 2000;
+// flush the text buffer to the file once it grows past this
+static const size_t flush_size = 64 * 1024;
+// entries formatted between clock checks
+static const int32_t entries_per_check = 64;
+
+static void FormatTable( std::string &out, int32_t id, const char *name, int32_t count, int32_t max )
+{
+	out += "table\t";
+	out += std::to_string( id );
+	out += '\t';
+	out += name;
+	out += '\t';
+	out += std::to_string( count );
+	out += '\t';
+	out += std::to_string( max );
+	out += '\n';
+}
+
+static void FormatClientSide( std::string &out, int32_t count )
+{
+	out += "clientside\t";
+	out += std::to_string( count );
+	out += '\n';
+}
+
+static void FormatEntry( std::string &out, int32_t index, const char *str, const void *userdata, int32_t length )
+{
+	static const char hex[] = "0123456789abcdef";
+
+	if( userdata == nullptr )
+		length = 0;
+
+	out += std::to_string( index );
+	out += '\t';
+	out += std::to_string( length );
+	out += '\t';
+
+	const uint8_t *bytes = static_cast<const uint8_t *>( userdata );
+	for( int32_t k = 0; k < length; ++k )
+	{
+		out += hex[bytes[k] >> 4];
+		out += hex[bytes[k] & 0xF];
+	}
+
+	out += '\t';
+	out += str;
+	out += '\n';
+}
+
+static int32_t GetCount( CNetworkStringDict *networkdict )
+{
+	return networkdict != nullptr ? networkdict->Count( ) : 0;
+}
+
+// Userdata as it was written, decoded when stable (nullptr for client-side entries) uses
+// the userdata codec. The result is only valid until the next call.
+static const void *GetUserData( CNetworkStringDict *networkdict, INetworkStringTable *stable, int32_t index, int32_t &length )
+{
+	if( stable == nullptr || !codec::IsEnabled( stable ) )
+	{
+		const CNetworkStringTableItem &item = networkdict->m_Items.Element( index );
+		length = item.m_nUserDataLength;
+		return item.m_pUserData;
+	}
+
+	static std::string buffer;
+	return codec::GetStringUserData( stable, index, length, buffer );
+}
+
+static void FormatEntry( std::string &out, CNetworkStringDict *networkdict, INetworkStringTable *stable, int32_t index )
+{
+	int32_t length = 0;
+	const void *userdata = GetUserData( networkdict, stable, index, length );
+	FormatEntry( out, index, networkdict->m_Items.Key( index ), userdata, length );
+}
+
+class DumpTask : public tasks::Task
+{
+public:
+	DumpTask( int32_t callback ) :
+		reference( callback )
+	{ }
+
+protected:
+	bool Finish( GarrysMod::Lua::ILuaBase *LUA, const char *error )
+	{
+		if( reference != -1 )
+		{
+			LUA->ReferencePush( reference );
+			LUA->PushBool( error == nullptr );
+			if( error != nullptr )
+				LUA->PushString( error );
+			else
+				LUA->PushNil( );
+
+			tasks::Call( LUA, 2 );
+			LUA->ReferenceFree( reference );
+			reference = -1;
+		}
+
+		return false;
+	}
+
+private:
+	int32_t reference;
+};
+
+// Formats the live tables on the main thread, a slice per frame
+class BudgetedDumpTask : public DumpTask
+{
+public:
+	BudgetedDumpTask( FileHandle_t handle, const std::vector<CNetworkStringTable *> &stringtables,
+		int32_t budget_us, int32_t callback ) :
+		DumpTask( callback ),
+		file( handle ),
+		budget( budget_us )
+	{
+		for( CNetworkStringTable *stable : stringtables )
+			tables.push_back( { stable, stable->GetTableId( ) } );
+	}
+
+	~BudgetedDumpTask( )
+	{
+		if( file != FILESYSTEM_INVALID_HANDLE )
+			InterfacePointers::FileSystem( )->Close( file );
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		const auto deadline = std::chrono::steady_clock::now( ) + std::chrono::microseconds( budget );
+		while( table < tables.size( ) )
+		{
+			const Table &current = tables[table];
+			if( !stringtablecontainer::IsAlive( current.stringtable, current.id ) )
+				return Finish( LUA, "stringtable was removed" );
+
+			if( !FormatSlice( current.stringtable ) )
+			{
+				++table;
+				entry = -1;
+				clientside = false;
+			}
+
+			if( text.size( ) >= flush_size && !Flush( ) )
+				return Finish( LUA, "unable to write file" );
+
+			if( std::chrono::steady_clock::now( ) >= deadline )
+				return true;
+		}
+
+		if( !Flush( ) )
+			return Finish( LUA, "unable to write file" );
+
+		InterfacePointers::FileSystem( )->Close( file );
+		file = FILESYSTEM_INVALID_HANDLE;
+		return Finish( LUA, nullptr );
+	}
+
+private:
+	struct Table
+	{
+		CNetworkStringTable *stringtable;
+		int32_t id;
+	};
+
+	// Formats up to entries_per_check entries, returns false once the table is done
+	bool FormatSlice( CNetworkStringTable *stable )
+	{
+		CNetworkStringDict *networkdict = clientside ? stable->m_pItemsClientSide : stable->m_pItems;
+		if( entry == -1 )
+		{
+			if( clientside )
+				FormatClientSide( text, GetCount( networkdict ) );
+			else
+				FormatTable( text, stable->GetTableId( ), stable->GetTableName( ), GetCount( networkdict ), stable->GetMaxStrings( ) );
+
+			entry = 0;
+		}
+
+		// the table may have shrunk since the last frame
+		const int32_t end = std::min( GetCount( networkdict ), entry + entries_per_check );
+		for( ; entry < end; ++entry )
+			FormatEntry( text, networkdict, clientside ? nullptr : stable, entry );
+
+		if( entry < GetCount( networkdict ) )
+			return true;
+
+		if( clientside || stable->m_pItemsClientSide == nullptr )
+			return false;
+
+		clientside = true;
+		entry = -1;
+		return true;
+	}
+
+	bool Flush( )
+	{
+		const int32_t size = static_cast<int32_t>( text.size( ) );
+		const bool written = InterfacePointers::FileSystem( )->Write( text.data( ), size, file ) == size;
+		text.clear( );
+		return written;
+	}
+
+	FileHandle_t file;
+	int32_t budget;
+	std::vector<Table> tables;
+	size_t table = 0;
+	int32_t entry = -1;
+	bool clientside = false;
+	std::string text;
+};
+
+// Copies the tables on the main thread, then formats and writes the copy on a worker
+class BackgroundDumpTask : public DumpTask
+{
+public:
+	BackgroundDumpTask( FileHandle_t handle, const std::vector<CNetworkStringTable *> &stringtables, int32_t callback ) :
+		DumpTask( callback ),
+		file( handle )
+	{
+		for( CNetworkStringTable *stable : stringtables )
+		{
+			copies.emplace_back( );
+			Copy &copy = copies.back( );
+			copy.id = stable->GetTableId( );
+			copy.name = stable->GetTableName( );
+			copy.max = stable->GetMaxStrings( );
+			CopyEntries( stable->m_pItems, stable, copy.entries );
+			copy.has_clientside = stable->m_pItemsClientSide != nullptr;
+			CopyEntries( stable->m_pItemsClientSide, nullptr, copy.clientside );
+		}
+
+		worker = std::thread( &BackgroundDumpTask::Work, this );
+	}
+
+	~BackgroundDumpTask( )
+	{
+		if( worker.joinable( ) )
+			worker.join( );
+
+		if( file != FILESYSTEM_INVALID_HANDLE )
+			InterfacePointers::FileSystem( )->Close( file );
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		if( !done )
+			return true;
+
+		worker.join( );
+		InterfacePointers::FileSystem( )->Close( file );
+		file = FILESYSTEM_INVALID_HANDLE;
+		return Finish( LUA, written ? nullptr : "unable to write file" );
+	}
+
+private:
+	struct Entry
+	{
+		std::string string;
+		std::string userdata;
+		bool has_userdata;
+	};
+
+	struct Copy
+	{
+		int32_t id;
+		std::string name;
+		int32_t max;
+		std::vector<Entry> entries;
+		bool has_clientside;
+		std::vector<Entry> clientside;
+	};
+
+	static void CopyEntries( CNetworkStringDict *networkdict, INetworkStringTable *stable, std::vector<Entry> &entries )
+	{
+		const int32_t count = GetCount( networkdict );
+		entries.resize( static_cast<size_t>( count ) );
+		for( int32_t i = 0; i < count; ++i )
+		{
+			Entry &entry = entries[i];
+			entry.string = networkdict->m_Items.Key( i );
+
+			int32_t length = 0;
+			const void *userdata = GetUserData( networkdict, stable, i, length );
+			entry.has_userdata = userdata != nullptr;
+			if( entry.has_userdata )
+				entry.userdata.assign( static_cast<const char *>( userdata ), static_cast<size_t>( length ) );
+		}
+	}
+
+	static void FormatEntries( std::string &text, const std::vector<Entry> &entries )
+	{
+		for( size_t i = 0; i < entries.size( ); ++i )
+		{
+			const Entry &entry = entries[i];
+			FormatEntry( text, static_cast<int32_t>( i ), entry.string.c_str( ),
+				entry.has_userdata ? entry.userdata.data( ) : nullptr, static_cast<int32_t>( entry.userdata.size( ) ) );
+		}
+	}
+
+	void Work( )
+	{
+		IFileSystem *filesystem = InterfacePointers::FileSystem( );
+		bool success = true;
+		std::string text;
+		for( const Copy &copy : copies )
+		{
+			FormatTable( text, copy.id, copy.name.c_str( ), static_cast<int32_t>( copy.entries.size( ) ), copy.max );
+			FormatEntries( text, copy.entries );
+			if( copy.has_clientside )
+			{
+				FormatClientSide( text, static_cast<int32_t>( copy.clientside.size( ) ) );
+				FormatEntries( text, copy.clientside );
+			}
+
+			const int32_t size = static_cast<int32_t>( text.size( ) );
+			success = success && filesystem->Write( text.data( ), size, file ) == size;
+			text.clear( );
+		}
+
+		written = success;
+		done = true;
+	}
+
+	FileHandle_t file;
+	std::vector<Copy> copies;
+	std::thread worker;
+	std::atomic<bool> done{ false };
+	std::atomic<bool> written{ false };
+};
+
+const char *Start( GarrysMod::Lua::ILuaBase *LUA, const char *path,
+	const std::vector<CNetworkStringTable *> &stringtables, int32_t options )
+{
+	int32_t budget_us = default_budget_us;
+	bool background = false;
+	int32_t callback = -1;
+	if( LUA->IsType( options, GarrysMod::Lua::Type::TABLE ) )
+	{
+		LUA->GetField( options, "budget_us" );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::NUMBER ) )
+			budget_us = std::max( static_cast<int32_t>( LUA->GetNumber( -1 ) ), 1 );
+
+		LUA->GetField( options, "background" );
+		background = LUA->GetBool( -1 );
+
+		LUA->GetField( options, "callback" );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::FUNCTION ) )
+			callback = LUA->ReferenceCreate( );
+		else
+			LUA->Pop( 1 );
+
+		LUA->Pop( 2 );
+	}
+
+	const char *error = nullptr;
+	FileHandle_t file = FILESYSTEM_INVALID_HANDLE;
+	if( !stringtablefile::IsValidPath( path ) )
+		error = "invalid path";
+	else if( ( file = InterfacePointers::FileSystem( )->Open( path, "wb", path_id ) ) == FILESYSTEM_INVALID_HANDLE )
+		error = "unable to open file for writing";
+
+	if( error != nullptr )
+	{
+		if( callback != -1 )
+			LUA->ReferenceFree( callback );
+
+		return error;
+	}
+
+	if( background )
+		tasks::Add( new BackgroundDumpTask( file, stringtables, callback ) );
+	else
+		tasks::Add( new BudgetedDumpTask( file, stringtables, budget_us, callback ) );
+
+	return nullptr;
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+class CNetworkStringTable;
+
+namespace dumpfile
+{
+
+// Dumps the tables to a text file relative to the DATA path, one tab separated line per
+// entry ("index, userdata length, userdata hex, string") under a "table" header line, and
+// the client side entries under a "clientside" line. The options table at index can set
+// budget_us (per frame formatting budget, default 2000), background (format a copy on a
+// worker thread instead) and callback (called with success and error once written).
+// Returns nullptr when the dump was started or an error message.
+const char *Start( GarrysMod::Lua::ILuaBase *LUA, const char *path,
+	const std::vector<CNetworkStringTable *> &stringtables, int32_t options );
+
+}
@@ -0,0 +1,171 @@
+#include "filevalidation.hpp"
+#include "tablesnapshot.hpp"
+#include "tasks.hpp"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <GarrysMod/InterfacePointers.hpp>
+#include <filesystem.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace filevalidation
+{
+
+static const int64_t missing_file = -1;
+static const int64_t not_a_file = -2;
+static const uint32_t max_workers = 8;
+
+// prefixes the sound system strips before looking up a file (mixing, spatialization, etc.)
+static const char sound_chars[] = "*#@<>^)}$!?&~";
+
+enum class Kind
+{
+	Plain,
+	Sounds,
+	Models
+};
+
+static Kind GetKind( const char *name )
+{
+	if( std::strcmp( name, "soundprecache" ) == 0 )
+		return Kind::Sounds;
+
+	if( std::strcmp( name, "modelprecache" ) == 0 )
+		return Kind::Models;
+
+	return Kind::Plain;
+}
+
+static bool IsMapPath( const char *path )
+{
+	const size_t length = std::strlen( path );
+	return std::strncmp( path, "maps/", 5 ) == 0 && length > 9 && std::strcmp( path + length - 4, ".bsp" ) == 0;
+}
+
+class ValidateTask : public tasks::Task
+{
+public:
+	ValidateTask( CNetworkStringTable *stable, int32_t callback ) :
+		snapshot( tablesnapshot::Snapshot::Create( stable ) ),
+		kind( GetKind( snapshot->GetName( ) ) ),
+		reference( callback ),
+		sizes( static_cast<size_t>( snapshot->GetCount( ) ), missing_file )
+	{
+		const uint32_t hardware = std::max( std::thread::hardware_concurrency( ), 2u ) - 1;
+		const uint32_t count = std::min( std::min( hardware, max_workers ),
+			static_cast<uint32_t>( std::max( snapshot->GetCount( ), 1 ) ) );
+		for( uint32_t k = 0; k < count; ++k )
+			workers.emplace_back( &ValidateTask::Work, this );
+	}
+
+	~ValidateTask( )
+	{
+		cancelled = true;
+		for( std::thread &worker : workers )
+			if( worker.joinable( ) )
+				worker.join( );
+
+		snapshot->Release( );
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		if( finished < workers.size( ) )
+			return true;
+
+		for( std::thread &worker : workers )
+			worker.join( );
+
+		LUA->ReferencePush( reference );
+
+		LUA->CreateTable( );
+		LUA->CreateTable( );
+		int32_t missing = 0;
+		for( int32_t i = 0; i < static_cast<int32_t>( sizes.size( ) ); ++i )
+		{
+			LUA->PushNumber( i );
+			if( sizes[i] == not_a_file )
+			{
+				LUA->PushBool( true );
+			}
+			else if( sizes[i] != missing_file )
+			{
+				LUA->PushNumber( static_cast<double>( sizes[i] ) );
+			}
+			else
+			{
+				LUA->PushBool( false );
+
+				LUA->PushNumber( ++missing );
+				LUA->PushString( snapshot->GetString( i, nullptr ) );
+				LUA->SetTable( -5 );
+			}
+
+			LUA->SetTable( -4 );
+		}
+
+		tasks::Call( LUA, 2 );
+		LUA->ReferenceFree( reference );
+		return false;
+	}
+
+private:
+	// Turns an entry into a GAME path, nullptr for entries that don't name a file
+	// (empty reserved slots, brush models and the map itself in modelprecache)
+	const char *Resolve( const char *str, std::string &buffer ) const
+	{
+		if( *str == '\0' )
+			return nullptr;
+
+		if( kind == Kind::Sounds )
+		{
+			buffer.assign( "sound/" ).append( str + std::strspn( str, sound_chars ) );
+			return buffer.c_str( );
+		}
+
+		if( kind == Kind::Models && ( *str == '*' || IsMapPath( str ) ) )
+			return nullptr;
+
+		return str;
+	}
+
+	void Work( )
+	{
+		IFileSystem *filesystem = InterfacePointers::FileSystem( );
+		std::string buffer;
+
+		// workers pull indices one at a time so slow paths don't stall a fixed range
+		const int32_t count = snapshot->GetCount( );
+		for( int32_t i = next++; i < count && !cancelled; i = next++ )
+		{
+			const char *path = Resolve( snapshot->GetString( i, nullptr ), buffer );
+			if( path == nullptr )
+				sizes[i] = not_a_file;
+			else if( filesystem->FileExists( path, "GAME" ) )
+				sizes[i] = filesystem->Size( path, "GAME" );
+		}
+
+		++finished;
+	}
+
+	const tablesnapshot::Snapshot *snapshot;
+	const Kind kind;
+	int32_t reference;
+	std::vector<int64_t> sizes;
+	std::vector<std::thread> workers;
+	std::atomic<int32_t> next{ 0 };
+	std::atomic<size_t> finished{ 0 };
+	std::atomic<bool> cancelled{ false };
+};
+
+void Validate( CNetworkStringTable *stable, int32_t callback )
+{
+	tasks::Add( new ValidateTask( stable, callback ) );
+}
+
+}
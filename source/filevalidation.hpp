@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+class CNetworkStringTable;
+
+namespace filevalidation
+{
+
+// Snapshots the table and stats every entry in the GAME search path on a pool of worker
+// threads. callback is a registry reference called on a later frame with a table of
+// index to size (false when missing) and the list of missing paths, then freed.
+// soundprecache entries are looked up under sound/ without their prefix characters.
+// Empty entries, and brush models and the map in modelprecache, aren't files and map to true.
+void Validate( CNetworkStringTable *stringtable, int32_t callback );
+
+}
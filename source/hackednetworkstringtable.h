@@ -183,6 +183,72 @@ public:
 		{
 			return m_data;
 		}
+
+		// Removes the hashtable entry of a handle, must be called while its key is still in place
+		void UnlinkKey( UtlHashHandle_t idx )
+		{
+			m_table.Remove( IndirectIndex( idx ) );
+		}
+
+		// Re-adds the hashtable entry of a handle after its key was moved into place
+		void LinkKey( UtlHashHandle_t idx )
+		{
+			m_table.Insert( IndirectIndex( idx ) );
+		}
+
+		int GetNumBuckets( )
+		{
+			return static_cast<HashtableInternals &>( m_table ).GetNumBuckets( );
+		}
+
+		// Calls func with the linear probe distance (slot minus home slot) of every used slot
+		template<typename Func>
+		void ForEachProbeDistance( Func func )
+		{
+			static_cast<HashtableInternals &>( m_table ).ForEachProbeDistance( func );
+		}
+
+		// Bytes used by the hashtable buckets
+		size_t GetBucketsMemoryUsage( )
+		{
+			return GetNumBuckets( ) * HashtableInternals::GetBucketSize( );
+		}
+
+		// Bytes used by the linked list nodes, including free ones
+		size_t GetNodesMemoryUsage( )
+		{
+			typedef UtlLinkedListElem_t<LinkedList_t::ElemType_t, LinkedList_t::IndexType_t> Node_t;
+			return m_data.NumAllocated( ) * sizeof( Node_t );
+		}
+
+	private:
+		class HashtableInternals : public Hashtable_t
+		{
+		public:
+			// allocated slots, 0 until the first insert allocates the table
+			int GetNumBuckets( ) const
+			{
+				return m_table.Count( );
+			}
+
+			template<typename Func>
+			void ForEachProbeDistance( Func func ) const
+			{
+				const int count = m_table.Count( );
+				const unsigned int mask = static_cast<unsigned int>( count - 1 );
+				for( int i = 0; i < count; ++i )
+				{
+					const unsigned int flags_and_hash = m_table[i].flags_and_hash;
+					if( ( flags_and_hash & FLAG_FREE ) == 0 )
+						func( static_cast<int>( ( static_cast<unsigned int>( i ) - ( flags_and_hash & MASK_HASH ) ) & mask ) );
+				}
+			}
+
+			static size_t GetBucketSize( )
+			{
+				return sizeof( entry_t );
+			}
+		};
 	};
 };
 
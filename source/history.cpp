@@ -0,0 +1,168 @@
+#include "history.hpp"
+#include "stringtablecontainer.hpp"
+#include "tasks.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace history
+{
+
+typedef CUtlVector<CNetworkStringTableItem::itemchange_s> ChangeList_t;
+
+struct Limit
+{
+	CNetworkStringTable *stringtable;
+	int32_t id;
+	int32_t limit;
+	int32_t checked_tick;
+};
+
+static std::vector<Limit> limits;
+static bool limiting = false;
+
+// Frees the oldest count changes in one go, always leaving at least one. A change whose
+// data is the item's current userdata is kept, freeing it would leave the item dangling.
+static size_t RemoveOldest( const CNetworkStringTableItem &item, ChangeList_t &changelist, int32_t count )
+{
+	count = std::min( count, changelist.Count( ) - 1 );
+	if( count <= 0 )
+		return 0;
+
+	size_t freed = 0;
+	int32_t write = 0;
+	for( int32_t k = 0; k < count; ++k )
+	{
+		CNetworkStringTableItem::itemchange_s &change = changelist[k];
+		if( change.data != nullptr && change.data == item.m_pUserData )
+		{
+			changelist[write++] = change;
+			continue;
+		}
+
+		if( change.data != nullptr )
+		{
+			freed += change.length;
+			delete[] change.data;
+		}
+	}
+
+	if( write == count )
+		return freed;
+
+	for( int32_t k = count; k < changelist.Count( ); ++k )
+		changelist[write++] = changelist[k];
+
+	changelist.RemoveMultiple( write, changelist.Count( ) - write );
+	return freed;
+}
+
+template<typename Trimmer>
+static size_t TrimItems( CNetworkStringTable *stable, const Trimmer &trimmer )
+{
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr || !stable->m_bChangeHistoryEnabled )
+		return 0;
+
+	CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	size_t freed = 0;
+	for( int32_t i = 0; i < dict.Count( ); ++i )
+	{
+		const CNetworkStringTableItem &item = dict.Element( i );
+		ChangeList_t *changelist = item.m_pChangeList;
+		if( changelist != nullptr && changelist->Count( ) > 1 )
+			freed += RemoveOldest( item, *changelist, trimmer( *changelist ) );
+	}
+
+	return freed;
+}
+
+size_t TrimOlderThan( CNetworkStringTable *stable, int32_t tick )
+{
+	return TrimItems( stable, [tick]( const ChangeList_t &changelist )
+	{
+		// changes are in tick order, everything before the newest one at or before tick goes
+		int32_t base = 0;
+		while( base + 1 < changelist.Count( ) && changelist[base + 1].tick <= tick )
+			++base;
+
+		return base;
+	} );
+}
+
+size_t TrimToLimit( CNetworkStringTable *stable, int32_t limit )
+{
+	limit = std::max( limit, 1 );
+	return TrimItems( stable, [limit]( const ChangeList_t &changelist )
+	{
+		return changelist.Count( ) - limit;
+	} );
+}
+
+class LimitTask : public tasks::Task
+{
+public:
+	LimitTask( )
+	{
+		limiting = true;
+	}
+
+	~LimitTask( )
+	{
+		limiting = false;
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase * ) override
+	{
+		for( size_t k = 0; k < limits.size( ); )
+		{
+			Limit &limit = limits[k];
+			if( !stringtablecontainer::IsAlive( limit.stringtable, limit.id ) )
+			{
+				limits.erase( limits.begin( ) + k );
+				continue;
+			}
+
+			if( limit.stringtable->ChangedSinceTick( limit.checked_tick ) )
+			{
+				TrimToLimit( limit.stringtable, limit.limit );
+				// changes later in this same tick must still be seen on the next frame
+				limit.checked_tick = limit.stringtable->m_nTickCount - 1;
+			}
+
+			++k;
+		}
+
+		return !limits.empty( );
+	}
+};
+
+void SetLimit( CNetworkStringTable *stable, int32_t limit )
+{
+	auto it = std::find_if( limits.begin( ), limits.end( ), [stable]( const Limit &entry )
+	{
+		return entry.stringtable == stable;
+	} );
+
+	if( limit <= 0 )
+	{
+		if( it != limits.end( ) )
+			limits.erase( it );
+
+		return;
+	}
+
+	if( it == limits.end( ) )
+		it = limits.insert( limits.end( ), Limit( ) );
+
+	it->stringtable = stable;
+	it->id = stable->GetTableId( );
+	it->limit = limit;
+	it->checked_tick = -1;
+
+	if( !limiting )
+		tasks::Add( new LimitTask );
+}
+
+}
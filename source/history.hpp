@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class CNetworkStringTable;
+
+namespace history
+{
+
+// Frees the change history (rollback tables only) entries that RestoreTick can no longer
+// need for ticks at or after tick. The newest entry at or before tick is kept as the base.
+// Returns the number of userdata bytes freed.
+size_t TrimOlderThan( CNetworkStringTable *stringtable, int32_t tick );
+
+// Keeps at most limit entries of history per item, limit is at least 1 (the current userdata)
+size_t TrimToLimit( CNetworkStringTable *stringtable, int32_t limit );
+
+// Enforces TrimToLimit every frame the table changed, limit <= 0 removes the cap
+void SetLimit( CNetworkStringTable *stringtable, int32_t limit );
+
+}
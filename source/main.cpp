@@ -1,17 +1,31 @@
 #include <GarrysMod/Lua/Interface.h>
 #include <stringtablecontainer.hpp>
 #include <stringtable.hpp>
+#include <tasks.hpp>
+#include <changes.hpp>
+#include <batch.hpp>
+#include <codec.hpp>
+#include <tablesnapshot.hpp>
+#include <stats.hpp>
 
 GMOD_MODULE_OPEN( )
 {
 	stringtablecontainer::Initialize( LUA );
 	stringtable::Initialize( LUA );
+	tablesnapshot::Initialize( LUA );
+	tasks::Initialize( LUA );
 	return 0;
 }
 
 GMOD_MODULE_CLOSE( )
 {
+	batch::Deinitialize( LUA );
+	changes::Deinitialize( LUA );
+	tasks::Deinitialize( LUA );
+	tablesnapshot::Deinitialize( LUA );
+	codec::Deinitialize( );
 	stringtable::Deinitialize( LUA );
 	stringtablecontainer::Deinitialize( LUA );
+	stats::Deinitialize( );
 	return 0;
 }
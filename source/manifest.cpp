@@ -0,0 +1,167 @@
+#include "manifest.hpp"
+#include "stringtablecontainer.hpp"
+#include "stringtablefile.hpp"
+#include "tasks.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace manifest
+{
+
+class LoadTask : public tasks::Task
+{
+public:
+	LoadTask( CNetworkStringTable *stable, const char *path, int32_t callback, int32_t batch_size, bool server ) :
+		stringtable( stable ),
+		id( stable->GetTableId( ) ),
+		reference( callback ),
+		batch( batch_size ),
+		is_server( server ),
+		file( path )
+	{
+		worker = std::thread( &LoadTask::Parse, this );
+	}
+
+	~LoadTask( )
+	{
+		cancelled = true;
+		if( worker.joinable( ) )
+			worker.join( );
+	}
+
+	bool Think( GarrysMod::Lua::ILuaBase *LUA ) override
+	{
+		if( !parsed )
+			return true;
+
+		if( worker.joinable( ) )
+			worker.join( );
+
+		if( error == nullptr && !stringtablecontainer::IsAlive( stringtable, id ) )
+			error = "stringtable was removed";
+
+		if( error != nullptr )
+			return Finish( LUA );
+
+		const size_t end = std::min( next + batch, entries.size( ) );
+		for( ; next < end; ++next )
+		{
+			const char *str = entries[next].c_str( );
+			if( stringtable->FindStringIndex( str ) != INVALID_STRING_INDEX ||
+				stringtable->AddString( is_server, str ) == INVALID_STRING_INDEX )
+				++skipped;
+			else
+				++added;
+		}
+
+		if( next >= entries.size( ) )
+			return Finish( LUA );
+
+		Report( LUA, false );
+		return true;
+	}
+
+private:
+	void Parse( )
+	{
+		std::vector<uint8_t> buffer;
+		if( !stringtablefile::ReadFile( file.c_str( ), buffer ) )
+		{
+			error = "unable to read file";
+			parsed = true;
+			return;
+		}
+
+		// string tables compare caselessly, so deduplicate the same way
+		std::unordered_set<std::string> seen;
+		std::string key;
+		const char *current = reinterpret_cast<const char *>( buffer.data( ) );
+		const char *end = current + buffer.size( );
+		while( current < end && !cancelled )
+		{
+			const char *line = current;
+			while( current < end && *current != '\n' )
+				++current;
+
+			const char *line_end = current++;
+			while( line < line_end && std::isspace( static_cast<unsigned char>( *line ) ) )
+				++line;
+
+			while( line_end > line && std::isspace( static_cast<unsigned char>( line_end[-1] ) ) )
+				--line_end;
+
+			if( line == line_end || *line == '#' || ( line_end - line >= 2 && line[0] == '/' && line[1] == '/' ) )
+				continue;
+
+			key.assign( line, line_end );
+			for( char &c : key )
+				c = static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) );
+
+			if( !seen.insert( key ).second )
+			{
+				++skipped;
+				continue;
+			}
+
+			entries.emplace_back( line, line_end );
+		}
+
+		parsed = true;
+	}
+
+	void Report( GarrysMod::Lua::ILuaBase *LUA, bool done )
+	{
+		LUA->ReferencePush( reference );
+		LUA->PushBool( done );
+		LUA->PushNumber( added );
+		LUA->PushNumber( static_cast<double>( entries.size( ) ) );
+		LUA->PushNumber( skipped );
+		if( error != nullptr )
+			LUA->PushString( error );
+		else
+			LUA->PushNil( );
+
+		tasks::Call( LUA, 5 );
+	}
+
+	bool Finish( GarrysMod::Lua::ILuaBase *LUA )
+	{
+		Report( LUA, true );
+		LUA->ReferenceFree( reference );
+		return false;
+	}
+
+	CNetworkStringTable *stringtable;
+	TABLEID id;
+	int32_t reference;
+	size_t batch;
+	bool is_server;
+	std::string file;
+
+	std::thread worker;
+	std::atomic<bool> cancelled{ false };
+	std::atomic<bool> parsed{ false };
+	// written by the worker thread before parsed is set
+	const char *error = nullptr;
+	std::vector<std::string> entries;
+
+	size_t next = 0;
+	int32_t added = 0;
+	int32_t skipped = 0;
+};
+
+void Load( CNetworkStringTable *stringtable, const char *path, int32_t callback, int32_t batch_size, bool is_server )
+{
+	tasks::Add( new LoadTask( stringtable, path, callback, batch_size, is_server ) );
+}
+
+}
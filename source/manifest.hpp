@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+class CNetworkStringTable;
+
+namespace manifest
+{
+
+// Parses and deduplicates a manifest (one entry per line, "//" and "#" comments) on a
+// worker thread, then adds the entries (to the is_server realm) on the main thread in
+// batches of batch_size.
+// callback is a registry reference that is called every frame with
+// done, added, total, skipped, error and is freed once the load is done.
+void Load( CNetworkStringTable *stringtable, const char *path, int32_t callback, int32_t batch_size, bool is_server );
+
+}
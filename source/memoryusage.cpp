@@ -0,0 +1,108 @@
+#include "memoryusage.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+
+#include <cstring>
+
+namespace memoryusage
+{
+
+size_t Usage::Total( ) const
+{
+	return table + items + strings + userdata + history + hashtable + clientside;
+}
+
+Usage &Usage::operator+=( const Usage &other )
+{
+	table += other.table;
+	items += other.items;
+	strings += other.strings;
+	userdata += other.userdata;
+	history += other.history;
+	hashtable += other.hashtable;
+	clientside += other.clientside;
+	return *this;
+}
+
+static void AccumulateDict( CNetworkStringDict *networkdict, Usage &usage )
+{
+	if( networkdict == nullptr )
+		return;
+
+	CNetworkStringDict::_StableHashtable_t &dict = static_cast<CNetworkStringDict::_StableHashtable_t &>( networkdict->m_Items );
+
+	usage.table += sizeof( CNetworkStringDict );
+	usage.items += dict.GetNodesMemoryUsage( );
+	usage.hashtable += dict.GetBucketsMemoryUsage( );
+
+	const int32_t count = dict.Count( );
+	for( int32_t i = 0; i < count; ++i )
+	{
+		usage.strings += std::strlen( dict.Key( i ) ) + 1;
+
+		const CNetworkStringTableItem &item = dict.Element( i );
+		const CUtlVector<CNetworkStringTableItem::itemchange_s> *changelist = item.m_pChangeList;
+		if( changelist == nullptr )
+		{
+			if( item.m_pUserData != nullptr )
+				usage.userdata += item.m_nUserDataLength;
+
+			continue;
+		}
+
+		// with history enabled the current userdata is owned by the last change
+		usage.history += sizeof( *changelist ) + changelist->NumAllocated( ) * sizeof( CNetworkStringTableItem::itemchange_s );
+		for( int32_t k = 0; k < changelist->Count( ); ++k )
+		{
+			const CNetworkStringTableItem::itemchange_s &change = changelist->Element( k );
+			if( change.data != nullptr )
+				usage.history += change.length;
+		}
+	}
+}
+
+Usage Get( CNetworkStringTable *stringtable )
+{
+	Usage usage;
+	usage.table = sizeof( CNetworkStringTable ) + std::strlen( stringtable->GetTableName( ) ) + 1;
+
+	AccumulateDict( stringtable->m_pItems, usage );
+
+	Usage clientside;
+	AccumulateDict( stringtable->m_pItemsClientSide, clientside );
+	usage.clientside = clientside.Total( );
+
+	return usage;
+}
+
+void Push( GarrysMod::Lua::ILuaBase *LUA, const Usage &usage )
+{
+	LUA->CreateTable( );
+
+	LUA->PushNumber( static_cast<double>( usage.table ) );
+	LUA->SetField( -2, "table" );
+
+	LUA->PushNumber( static_cast<double>( usage.items ) );
+	LUA->SetField( -2, "items" );
+
+	LUA->PushNumber( static_cast<double>( usage.strings ) );
+	LUA->SetField( -2, "strings" );
+
+	LUA->PushNumber( static_cast<double>( usage.userdata ) );
+	LUA->SetField( -2, "userdata" );
+
+	LUA->PushNumber( static_cast<double>( usage.history ) );
+	LUA->SetField( -2, "history" );
+
+	LUA->PushNumber( static_cast<double>( usage.hashtable ) );
+	LUA->SetField( -2, "hashtable" );
+
+	LUA->PushNumber( static_cast<double>( usage.clientside ) );
+	LUA->SetField( -2, "clientside" );
+
+	LUA->PushNumber( static_cast<double>( usage.Total( ) ) );
+	LUA->SetField( -2, "total" );
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+class CNetworkStringTable;
+
+namespace memoryusage
+{
+
+// Bytes used by a stringtable, per category
+struct Usage
+{
+	size_t table = 0;
+	size_t items = 0;
+	size_t strings = 0;
+	size_t userdata = 0;
+	size_t history = 0;
+	size_t hashtable = 0;
+	size_t clientside = 0;
+
+	size_t Total( ) const;
+	Usage &operator+=( const Usage &other );
+};
+
+Usage Get( CNetworkStringTable *stringtable );
+// Pushes a table with one field per category plus "total"
+void Push( GarrysMod::Lua::ILuaBase *LUA, const Usage &usage );
+
+}
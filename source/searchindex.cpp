@@ -0,0 +1,115 @@
+#include "searchindex.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace searchindex
+{
+
+std::string Index::Normalize( const char *str )
+{
+	std::string normalized( str );
+	for( char &c : normalized )
+		c = c == '\\' ? '/' : static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) );
+
+	return normalized;
+}
+
+const char *Index::Entry( uint32_t index ) const
+{
+	return text.c_str( ) + starts[index];
+}
+
+uint32_t Index::EntryFromOffset( uint32_t offset ) const
+{
+	return static_cast<uint32_t>( std::upper_bound( starts.begin( ), starts.end( ), offset ) - starts.begin( ) ) - 1;
+}
+
+void Index::Invalidate( )
+{
+	valid = false;
+}
+
+void Index::Update( CNetworkStringTable *stringtable )
+{
+	CNetworkStringDict *networkdict = stringtable->m_pItems;
+	const int32_t count = networkdict != nullptr ? static_cast<int32_t>( networkdict->Count( ) ) : 0;
+	if( valid && built_tick == stringtable->m_nLastChangedTick && built_count == count )
+		return;
+
+	text.clear( );
+	starts.resize( count );
+	sorted.resize( count );
+	suffixes.clear( );
+	has_suffixes = false;
+
+	for( int32_t i = 0; i < count; ++i )
+	{
+		starts[i] = static_cast<uint32_t>( text.size( ) );
+		text += Normalize( networkdict->m_Items.Key( i ) );
+		text += '\0';
+		sorted[i] = static_cast<uint32_t>( i );
+	}
+
+	std::sort( sorted.begin( ), sorted.end( ), [this]( uint32_t a, uint32_t b )
+	{
+		return std::strcmp( Entry( a ), Entry( b ) ) < 0;
+	} );
+
+	valid = true;
+	built_tick = stringtable->m_nLastChangedTick;
+	built_count = count;
+}
+
+void Index::FindByPrefix( const char *prefix, std::vector<int32_t> &indices ) const
+{
+	const std::string normalized = Normalize( prefix );
+	const char *str = normalized.c_str( );
+	const size_t len = normalized.size( );
+
+	auto it = std::lower_bound( sorted.begin( ), sorted.end( ), str, [this]( uint32_t index, const char *value )
+	{
+		return std::strcmp( Entry( index ), value ) < 0;
+	} );
+	for( ; it != sorted.end( ) && std::strncmp( Entry( *it ), str, len ) == 0; ++it )
+		indices.push_back( static_cast<int32_t>( *it ) );
+}
+
+void Index::FindMatching( const char *substring, std::vector<int32_t> &indices )
+{
+	if( !has_suffixes )
+	{
+		for( uint32_t offset = 0; offset < text.size( ); ++offset )
+			if( text[offset] != '\0' )
+				suffixes.push_back( offset );
+
+		const char *base = text.c_str( );
+		std::sort( suffixes.begin( ), suffixes.end( ), [base]( uint32_t a, uint32_t b )
+		{
+			return std::strcmp( base + a, base + b ) < 0;
+		} );
+
+		has_suffixes = true;
+	}
+
+	const std::string normalized = Normalize( substring );
+	const char *str = normalized.c_str( );
+	const size_t len = normalized.size( );
+	const char *base = text.c_str( );
+
+	const size_t first = indices.size( );
+	auto it = std::lower_bound( suffixes.begin( ), suffixes.end( ), str, [base]( uint32_t offset, const char *value )
+	{
+		return std::strcmp( base + offset, value ) < 0;
+	} );
+	for( ; it != suffixes.end( ) && std::strncmp( base + *it, str, len ) == 0; ++it )
+		indices.push_back( static_cast<int32_t>( EntryFromOffset( *it ) ) );
+
+	// a string can contain the substring more than once
+	std::sort( indices.begin( ) + first, indices.end( ) );
+	indices.erase( std::unique( indices.begin( ) + first, indices.end( ) ), indices.end( ) );
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CNetworkStringTable;
+
+namespace searchindex
+{
+
+// Lazily built, caseless search structures over a stringtable's strings. Backslashes
+// are treated as forward slashes so filename tables match either separator.
+class Index
+{
+public:
+	// Rebuilds the sorted index if the table changed since it was built
+	void Update( CNetworkStringTable *stringtable );
+	void Invalidate( );
+
+	// O(log n + k) over the sorted strings
+	void FindByPrefix( const char *prefix, std::vector<int32_t> &indices ) const;
+	// O(m log L + k) over a suffix array of all strings, built on first use
+	void FindMatching( const char *substring, std::vector<int32_t> &indices );
+
+private:
+	static std::string Normalize( const char *str );
+	const char *Entry( uint32_t index ) const;
+	uint32_t EntryFromOffset( uint32_t offset ) const;
+
+	bool valid = false;
+	int32_t built_tick = -1;
+	int32_t built_count = -1;
+
+	// normalized strings separated by '\0' and the offset of each one, by string index
+	std::string text;
+	std::vector<uint32_t> starts;
+	// string indices sorted by normalized string
+	std::vector<uint32_t> sorted;
+	// offsets of every suffix of every string, sorted
+	std::vector<uint32_t> suffixes;
+	bool has_suffixes = false;
+};
+
+}
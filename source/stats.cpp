@@ -0,0 +1,182 @@
+#include "stats.hpp"
+#include "stringtable.hpp"
+#include "stringtablecontainer.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <lua.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace stats
+{
+
+// bucket 0 is under 1us, bucket k covers [2^(k-1), 2^k) us and the last one everything above
+static const size_t histogram_buckets = 21;
+
+struct Record
+{
+	uint64_t calls = 0;
+	std::chrono::nanoseconds total{ 0 };
+	uint64_t histogram[histogram_buckets] = { };
+
+	void Add( std::chrono::nanoseconds elapsed )
+	{
+		++calls;
+		total += elapsed;
+
+		uint64_t micro = static_cast<uint64_t>( elapsed.count( ) ) / 1000;
+		size_t bucket = 0;
+		while( micro != 0 && bucket < histogram_buckets - 1 )
+		{
+			micro >>= 1;
+			++bucket;
+		}
+
+		++histogram[bucket];
+	}
+};
+
+struct TableRecord
+{
+	int32_t id = -1;
+	Record record;
+};
+
+struct FunctionRecord
+{
+	FunctionRecord( CFunction func, const char *funcname ) :
+		function( func ),
+		name( funcname )
+	{ }
+
+	CFunction function;
+	std::string name;
+	Record record;
+	std::unordered_map<const CNetworkStringTable *, TableRecord> tables;
+};
+
+static bool enabled = false;
+static std::vector<std::unique_ptr<FunctionRecord>> functions;
+
+LUA_FUNCTION_STATIC( Profiled )
+{
+	FunctionRecord *function = static_cast<FunctionRecord *>( LUA->GetUserdata( lua_upvalueindex( 1 ) ) );
+	if( !enabled )
+		return function->function( LUA->GetState( ) );
+
+	const CNetworkStringTable *stable = stringtable::Test( LUA, 1 );
+
+	const auto start = std::chrono::steady_clock::now( );
+	const int32_t results = function->function( LUA->GetState( ) );
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - start );
+
+	function->record.Add( elapsed );
+	if( stable != nullptr )
+	{
+		// a table recreated at the same address starts over
+		TableRecord &table = function->tables[stable];
+		const int32_t id = stable->GetTableId( );
+		if( table.id != id )
+		{
+			table.id = id;
+			table.record = Record( );
+		}
+
+		table.record.Add( elapsed );
+	}
+
+	return results;
+}
+
+void PushCFunction( GarrysMod::Lua::ILuaBase *LUA, CFunction function, const char *name )
+{
+	functions.emplace_back( new FunctionRecord( function, name ) );
+	LUA->PushUserdata( functions.back( ).get( ) );
+	LUA->PushCClosure( Profiled, 1 );
+}
+
+void Enable( bool enable )
+{
+	enabled = enable;
+}
+
+void Reset( )
+{
+	for( auto &function : functions )
+	{
+		function->record = Record( );
+		function->tables.clear( );
+	}
+}
+
+static void PushRecord( GarrysMod::Lua::ILuaBase *LUA, const Record &record )
+{
+	LUA->CreateTable( );
+
+	LUA->PushNumber( static_cast<double>( record.calls ) );
+	LUA->SetField( -2, "calls" );
+
+	LUA->PushNumber( std::chrono::duration<double>( record.total ).count( ) );
+	LUA->SetField( -2, "total" );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < histogram_buckets; ++k )
+	{
+		LUA->PushNumber( static_cast<double>( k + 1 ) );
+		LUA->PushNumber( static_cast<double>( record.histogram[k] ) );
+		LUA->SetTable( -3 );
+	}
+
+	LUA->SetField( -2, "histogram" );
+}
+
+void Push( GarrysMod::Lua::ILuaBase *LUA )
+{
+	LUA->CreateTable( );
+
+	for( const auto &function : functions )
+	{
+		if( function->record.calls == 0 )
+			continue;
+
+		PushRecord( LUA, function->record );
+
+		// keyed by table ID since names can be shared or changed, the name is read now
+		LUA->CreateTable( );
+		for( auto it = function->tables.begin( ); it != function->tables.end( ); )
+		{
+			const CNetworkStringTable *stable = it->first;
+			if( !stringtablecontainer::IsAlive( stable, it->second.id ) )
+			{
+				// the table was removed or recreated, its numbers are meaningless now
+				it = function->tables.erase( it );
+				continue;
+			}
+
+			LUA->PushNumber( it->second.id );
+			PushRecord( LUA, it->second.record );
+			LUA->PushString( stable->GetTableName( ) );
+			LUA->SetField( -2, "name" );
+			LUA->SetTable( -3 );
+			++it;
+		}
+
+		LUA->SetField( -2, "tables" );
+
+		LUA->SetField( -2, function->name.c_str( ) );
+	}
+}
+
+void Deinitialize( )
+{
+	enabled = false;
+	functions.clear( );
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+struct lua_State;
+
+namespace stats
+{
+
+typedef int ( *CFunction )( lua_State *state );
+
+// Pushes a closure that calls function and, while stats are enabled, records its call
+// count, total time and latency histogram under name (and per stringtable, when the
+// first argument is one). When disabled the overhead is a single branch.
+void PushCFunction( GarrysMod::Lua::ILuaBase *LUA, CFunction function, const char *name );
+
+void Enable( bool enable );
+void Reset( );
+// Per function records with a "tables" field keyed by table ID (each record has the table's
+// current name), records of removed or recreated tables are dropped
+void Push( GarrysMod::Lua::ILuaBase *LUA );
+
+void Deinitialize( );
+
+}
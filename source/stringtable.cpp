@@ -1,12 +1,32 @@
 #include "stringtable.hpp"
 #include "stringtablecontainer.hpp"
+#include "stringtablefile.hpp"
+#include "manifest.hpp"
+#include "memoryusage.hpp"
+#include "stats.hpp"
+#include "searchindex.hpp"
+#include "changes.hpp"
+#include "updatesize.hpp"
+#include "batch.hpp"
+#include "history.hpp"
+#include "tablesnapshot.hpp"
+#include "filevalidation.hpp"
+#include "codec.hpp"
+#include "blob.hpp"
+#include "dumpfile.hpp"
 #include "hackednetworkstringtable.h"
 
 #include <GarrysMod/Lua/Interface.h>
 #include <lua.hpp>
+#include <tier1/strtools.h>
 
 #include <cstdint>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 void CNetworkStringTable::Dump( )
 {
@@ -26,11 +46,37 @@ void CNetworkStringTable::Dump( )
 namespace stringtable
 {
 
+// Identifies the state of an item when its Lua string was cached
+struct CacheStamp
+{
+	int32_t tick = -1;
+	const void *data = nullptr;
+	int32_t length = -1;
+
+	bool operator==( const CacheStamp &other ) const
+	{
+		return tick == other.tick && data == other.data && length == other.length;
+	}
+};
+
+// Opt-in per table cache of Lua strings, keyed by string index
+struct Cache
+{
+	int32_t strings = -1;
+	int32_t userdata = -1;
+	std::vector<CacheStamp> string_stamps;
+	std::vector<CacheStamp> userdata_stamps;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
 struct Container
 {
 	CNetworkStringTable *stringtable;
 	char *name_original;
 	char name[64];
+	Cache *cache;
+	searchindex::Index *search;
 };
 
 static const char metaname[] = "stringtable";
@@ -49,14 +95,195 @@ inline Container *GetUserdata( GarrysMod::Lua::ILuaBase *LUA, int index )
 	return LUA->GetUserType<Container>( index, metatype );
 }
 
-static CNetworkStringTable *Get( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
+static Container *GetContainer( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
 {
 	CheckType( LUA, index );
 	Container *udata = GetUserdata( LUA, index );
 	if( udata == nullptr )
 		LUA->ArgError( index, invalid_error );
 
-	return udata->stringtable;
+	return udata;
+}
+
+static CNetworkStringTable *Get( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
+{
+	return GetContainer( LUA, index )->stringtable;
+}
+
+inline int32_t OptionalInteger( GarrysMod::Lua::ILuaBase *LUA, int32_t index, int32_t def )
+{
+	const int32_t type = LUA->GetType( index );
+	if( type == GarrysMod::Lua::Type::NONE || type == GarrysMod::Lua::Type::NIL )
+		return def;
+
+	return static_cast<int32_t>( LUA->CheckNumber( index ) );
+}
+
+bool GetRealmArgument( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
+{
+	if( LUA->IsType( index, GarrysMod::Lua::Type::BOOL ) )
+		return LUA->GetBool( index );
+
+	LUA->GetField( GarrysMod::Lua::INDEX_GLOBAL, "SERVER" );
+	const bool is_server = LUA->GetBool( -1 );
+	LUA->Pop( 1 );
+	return is_server;
+}
+
+// Pushes the userdata a reader should see, including writes staged by BeginBatch
+static void PushStringUserData( GarrysMod::Lua::ILuaBase *LUA, INetworkStringTable *stable, int32_t index )
+{
+	const std::string *staged = batch::GetStaged( static_cast<CNetworkStringTable *>( stable ), index );
+	if( staged != nullptr )
+	{
+		LUA->PushString( staged->data( ), static_cast<unsigned int>( staged->size( ) ) );
+		return;
+	}
+
+	static std::string buffer;
+	int32_t len = 0;
+	const char *userdata = static_cast<const char *>( codec::GetStringUserData( stable, index, len, buffer ) );
+	LUA->PushString( userdata, len );
+}
+
+static void DestroyCache( GarrysMod::Lua::ILuaBase *LUA, Container *udata )
+{
+	Cache *cache = udata->cache;
+	if( cache == nullptr )
+		return;
+
+	LUA->ReferenceFree( cache->strings );
+	LUA->ReferenceFree( cache->userdata );
+	delete cache;
+	udata->cache = nullptr;
+}
+
+// Drops data derived from the table's contents. Used by our own mutations, which can
+// move keys or reuse userdata buffers without the table's ticks changing.
+static void Invalidate( Container *udata )
+{
+	Cache *cache = udata->cache;
+	if( cache != nullptr )
+	{
+		cache->string_stamps.clear( );
+		cache->userdata_stamps.clear( );
+	}
+
+	if( udata->search != nullptr )
+		udata->search->Invalidate( );
+}
+
+static void InvalidateCachedUserData( Container *udata, int32_t index )
+{
+	Cache *cache = udata->cache;
+	if( cache != nullptr && index >= 0 && static_cast<size_t>( index ) < cache->userdata_stamps.size( ) )
+		cache->userdata_stamps[index] = CacheStamp( );
+}
+
+// Pushes the cached Lua string for an index if the stamp still matches and matchfunc
+// accepts the cached value (on top of the stack), otherwise calls pushfunc and caches
+// its result. Returns false for indices that aren't cacheable.
+template<typename PushFunc, typename MatchFunc>
+static bool PushCached( GarrysMod::Lua::ILuaBase *LUA, Cache &cache, int32_t reference,
+	std::vector<CacheStamp> &stamps, int32_t index, const CacheStamp &stamp, PushFunc pushfunc, MatchFunc matchfunc )
+{
+	if( static_cast<size_t>( index ) >= stamps.size( ) )
+		stamps.resize( index + 1 );
+
+	if( stamps[index] == stamp )
+	{
+		LUA->ReferencePush( reference );
+		LUA->PushNumber( index );
+		LUA->RawGet( -2 );
+		LUA->Remove( -2 );
+		if( matchfunc( ) )
+		{
+			++cache.hits;
+			return true;
+		}
+
+		LUA->Pop( 1 );
+	}
+
+	++cache.misses;
+	pushfunc( );
+
+	LUA->ReferencePush( reference );
+	LUA->PushNumber( index );
+	LUA->Push( -3 );
+	LUA->RawSet( -3 );
+	LUA->Pop( 1 );
+
+	stamps[index] = stamp;
+	return true;
+}
+
+static bool PushCachedString( GarrysMod::Lua::ILuaBase *LUA, Container *udata, int32_t index )
+{
+	CNetworkStringDict *networkdict = udata->stringtable->m_pItems;
+	if( udata->cache == nullptr || networkdict == nullptr ||
+		index < 0 || index >= static_cast<int32_t>( networkdict->Count( ) ) )
+		return false;
+
+	CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	const CNetworkStringTableItem &item = dict.Element( index );
+	const char *str = dict.Key( index );
+
+	CacheStamp stamp;
+	stamp.tick = std::max( item.GetTickChanged( ), item.GetTickCreated( ) );
+	stamp.data = str;
+
+	Cache &cache = *udata->cache;
+	return PushCached( LUA, cache, cache.strings, cache.string_stamps, index, stamp, [LUA, str]( )
+	{
+		LUA->PushString( str );
+	}, []( )
+	{
+		// keys are only replaced by SetString, which invalidates the cache itself
+		return true;
+	} );
+}
+
+static bool PushCachedUserData( GarrysMod::Lua::ILuaBase *LUA, Container *udata, int32_t index )
+{
+	CNetworkStringTable *stable = udata->stringtable;
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	// encoded userdata would have to be decoded again to be compared, don't cache it
+	if( udata->cache == nullptr || networkdict == nullptr || codec::IsEnabled( stable ) ||
+		index < 0 || index >= static_cast<int32_t>( networkdict->Count( ) ) )
+		return false;
+
+	const CNetworkStringTableItem &item = networkdict->m_Items.Element( index );
+
+	CacheStamp stamp;
+	stamp.tick = std::max( item.GetTickChanged( ), item.GetTickCreated( ) );
+	stamp.data = item.m_pUserData;
+	stamp.length = item.m_nUserDataLength;
+
+	Cache &cache = *udata->cache;
+	return PushCached( LUA, cache, cache.userdata, cache.userdata_stamps, index, stamp, [LUA, stable, index]( )
+	{
+		PushStringUserData( LUA, stable, index );
+	}, [LUA, &item]( )
+	{
+		if( item.m_pUserData == nullptr )
+			return true;
+
+		// the allocator can hand a replaced buffer the same address within a tick
+		unsigned int length = 0;
+		const char *cached = LUA->GetString( -1, &length );
+		return cached != nullptr && length == static_cast<unsigned int>( item.m_nUserDataLength ) &&
+			std::memcmp( cached, item.m_pUserData, length ) == 0;
+	} );
+}
+
+CNetworkStringTable *Test( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
+{
+	if( !LUA->IsType( index, metatype ) )
+		return nullptr;
+
+	Container *udata = GetUserdata( LUA, index );
+	return udata != nullptr ? udata->stringtable : nullptr;
 }
 
 void Push( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable )
@@ -81,6 +308,8 @@ void Push( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable )
 	Container *udata = LUA->NewUserType<Container>( metatype );
 	udata->stringtable = stringtable;
 	udata->name_original = stringtable->m_pszTableName;
+	udata->cache = nullptr;
+	udata->search = nullptr;
 
 	LUA->PushMetaTable( metatype );
 	LUA->SetMetaTable( -2 );
@@ -94,6 +323,21 @@ void Push( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable )
 	LUA->Remove( -2 );
 }
 
+void Invalidate( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable )
+{
+	LUA->GetField( GarrysMod::Lua::INDEX_REGISTRY, table_name );
+	LUA->PushUserdata( stringtable );
+	LUA->GetTable( -2 );
+	if( LUA->IsType( -1, metatype ) )
+	{
+		Container *udata = GetUserdata( LUA, -1 );
+		if( udata != nullptr )
+			Invalidate( udata );
+	}
+
+	LUA->Pop( 2 );
+}
+
 static void Destroy( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
 {
 	Container *udata = GetUserdata( LUA, index );
@@ -109,6 +353,10 @@ static void Destroy( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
 	LUA->Pop( 1 );
 
 	stringtable->m_pszTableName = udata->name_original;
+	stringtablecontainer::InvalidateNameIndex( );
+
+	DestroyCache( LUA, udata );
+	delete udata->search;
 	
 	LUA->SetUserType( index, nullptr );
 }
@@ -165,6 +413,7 @@ LUA_FUNCTION_STATIC( SetName )
 
 	V_strncpy( udata->name, LUA->CheckString( 2 ), sizeof( udata->name ) );
 	udata->stringtable->m_pszTableName = udata->name;
+	stringtablecontainer::InvalidateNameIndex( );
 
 	return 0;
 }
@@ -211,222 +460,1224 @@ LUA_FUNCTION_STATIC( ChangedSinceTick )
 	return 1;
 }
 
-LUA_FUNCTION_STATIC( AddString )
+inline bool ItemChangedSinceTick( const CNetworkStringTableItem &item, int32_t tick )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::BOOL );
-	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
-
-	LUA->PushNumber( stable->AddString( LUA->GetBool( 2 ), LUA->GetString( 3 ) ) );
-	return 1;
+	return item.GetTickChanged( ) > tick || item.GetTickCreated( ) > tick;
 }
 
-LUA_FUNCTION_STATIC( SetString )
+LUA_FUNCTION_STATIC( CountChangedSince )
 {
 	CNetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
-	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
-
-	uint32_t index = static_cast<uint32_t>( LUA->GetNumber( 2 ) );
-
-	const char *str = LUA->GetString( 3 );
-	if( stable->FindStringIndex( str ) != INVALID_STRING_INDEX )
-	{
-		LUA->PushBool( false );
-		return 1;
-	}
+	const int32_t tick = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
 
+	int32_t count = 0;
 	CNetworkStringDict *networkdict = stable->m_pItems;
-	if( networkdict == nullptr )
-	{
-		LUA->PushBool( false );
-		return 1;
-	}
-
-	CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
-	if( !dict.IsValidHandle( index ) )
+	if( networkdict != nullptr && stable->ChangedSinceTick( tick ) )
 	{
-		LUA->PushBool( false );
-		return 1;
+		const CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+		for( int32_t i = 0; i < dict.Count( ); ++i )
+			if( ItemChangedSinceTick( dict.Element( i ), tick ) )
+				++count;
 	}
 
-	dict.ReplaceKey( index, str );
-	dict.Element( index ).m_nTickCreated = stable->m_nTickCount + 5;
-
-	LUA->PushBool( true );
-	return 1;
-}
-
-LUA_FUNCTION_STATIC( GetString )
-{
-	INetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
-
-	const char *str = stable->GetString( static_cast<int32_t>( LUA->GetNumber( 2 ) ) );
-	if( str == nullptr )
-		return 0;
-
-	LUA->PushString( str );
+	LUA->PushNumber( count );
 	return 1;
 }
 
-LUA_FUNCTION_STATIC( DeleteString )
+LUA_FUNCTION_STATIC( GetChangedSince )
 {
 	CNetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
-
-	uint32_t index = static_cast<uint32_t>( LUA->GetNumber( 2 ) );
+	const int32_t tick = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+	const bool with_data = LUA->GetBool( 3 );
 
-	CNetworkStringDict *networkdict = stable->m_pItems;
-	if( networkdict == nullptr )
+	LUA->CreateTable( );
+	if( with_data )
 	{
-		LUA->PushBool( false );
-		return 1;
+		LUA->CreateTable( );
+		LUA->CreateTable( );
 	}
 
-	CNetworkStringDict::_StableHashtable_t &dict = static_cast<CNetworkStringDict::_StableHashtable_t &>( networkdict->m_Items );
-	if( !dict.IsValidHandle( index ) )
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr || !stable->ChangedSinceTick( tick ) )
+		return with_data ? 3 : 1;
+
+	const CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	int32_t count = 0;
+	for( int32_t i = 0; i < dict.Count( ); ++i )
 	{
-		LUA->PushBool( false );
-		return 1;
-	}
+		if( !ItemChangedSinceTick( dict.Element( i ), tick ) )
+			continue;
 
-	uint32_t max = dict.Count( ) - 1;
+		++count;
 
-	auto &hashtable = dict.GetHashTable( );
-	UtlHashHandle_t first = hashtable.FirstHandle( ), idx = hashtable.InvalidHandle( );
-	for( UtlHashHandle_t k = first; k != hashtable.InvalidHandle( ); k = hashtable.NextHandle( k ) )
-		if( hashtable.Key( k ).m_index == max )
-			idx = k;
+		LUA->PushNumber( count );
+		LUA->PushNumber( i );
+		LUA->SetTable( with_data ? -5 : -3 );
 
-	hashtable.RemoveAndAdvance( idx != hashtable.InvalidHandle( ) ? idx : first );
+		if( with_data )
+		{
+			LUA->PushNumber( count );
+			LUA->PushString( stable->GetString( i ) );
+			LUA->SetTable( -4 );
 
-	auto &linkedlist = dict.GetLinkedList( );
-	for( uint32_t k = index; k < max; ++k )
-	{
-		linkedlist[k].m_key = linkedlist[k + 1].m_key;
-		std::swap( linkedlist[k].m_value, linkedlist[k + 1].m_value );
+			LUA->PushNumber( count );
+			PushStringUserData( LUA, stable, i );
+			LUA->SetTable( -3 );
+		}
 	}
 
-	linkedlist.Remove( max );
-
-	LUA->PushBool( true );
-	return 1;
+	return with_data ? 3 : 1;
 }
 
-LUA_FUNCTION_STATIC( SetStringUserData )
+LUA_FUNCTION_STATIC( EstimateUpdateBits )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
-	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	const int32_t tick = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
 
-	unsigned int len = 0;
-	const char *userdata = LUA->GetString( 3, &len );
-	stable->SetStringUserData( static_cast<int32_t>( LUA->GetNumber( 2 ) ), static_cast<int32_t>( len ), userdata );
-	return 0;
+	const updatesize::Estimate estimate = updatesize::Get( stable, tick );
+	LUA->PushNumber( static_cast<double>( estimate.bits ) );
+	LUA->PushNumber( static_cast<double>( ( estimate.message_bits + 7 ) / 8 ) );
+	LUA->PushNumber( estimate.entries );
+	return 3;
 }
 
-LUA_FUNCTION_STATIC( GetStringUserData )
+LUA_FUNCTION_STATIC( AddString )
 {
 	INetworkStringTable *stable = Get( LUA, 1 );
-	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
-
-	int32_t len = 0;
-	const char *userdata = static_cast<const char *>( stable->GetStringUserData( static_cast<int32_t>( LUA->GetNumber( 2 ) ), &len ) );
-	LUA->PushString( userdata, len );
-	return 1;
-}
+	LUA->CheckType( 2, GarrysMod::Lua::Type::BOOL );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
 
-LUA_FUNCTION_STATIC( FindStringIndex )
-{
-	LUA->PushNumber( Get( LUA, 1 )->FindStringIndex( LUA->CheckString( 2 ) ) );
+	LUA->PushNumber( stable->AddString( LUA->GetBool( 2 ), LUA->GetString( 3 ) ) );
 	return 1;
 }
 
-LUA_FUNCTION_STATIC( SetAllowClientSideAddString )
+LUA_FUNCTION_STATIC( AddStrings )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
+	Container *udata = GetContainer( LUA, 1 );
+	INetworkStringTable *stable = udata->stringtable;
 	LUA->CheckType( 2, GarrysMod::Lua::Type::BOOL );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::TABLE );
+	const bool has_userdata = !LUA->IsType( 4, GarrysMod::Lua::Type::NIL );
+	if( has_userdata )
+		LUA->CheckType( 4, GarrysMod::Lua::Type::TABLE );
 
-	stringtablecontainer::stcinternal->SetAllowClientSideAddString( stable, LUA->GetBool( 2 ) );
-	return 0;
-}
+	const bool is_server = LUA->GetBool( 2 );
+	const int32_t count = LUA->ObjLen( 3 );
 
-LUA_FUNCTION_STATIC( DeleteAllStrings )
-{
-	CNetworkStringTable *stable = Get( LUA, 1 );
+	LUA->CreateTable( );
+	LUA->CreateTable( );
+	int32_t failures = 0;
 
-	CNetworkStringDict *networkdict = stable->m_pItems;
-	if( networkdict == nullptr || networkdict->Count( ) == 0 )
+	for( int32_t k = 1; k <= count; ++k )
 	{
-		LUA->PushBool( false );
-		return 1;
+		int32_t index = INVALID_STRING_INDEX;
+
+		LUA->PushNumber( k );
+		LUA->RawGet( 3 );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+		{
+			const char *str = LUA->GetString( -1 );
+			if( has_userdata )
+			{
+				LUA->PushNumber( k );
+				LUA->RawGet( 4 );
+				if( LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+				{
+					unsigned int len = 0;
+					const char *userdata = LUA->GetString( -1, &len );
+					index = codec::AddString( stable, is_server, str, userdata, static_cast<int32_t>( len ) );
+				}
+				else
+				{
+					index = stable->AddString( is_server, str );
+				}
+
+				LUA->Pop( 1 );
+			}
+			else
+			{
+				index = stable->AddString( is_server, str );
+			}
+		}
+
+		LUA->Pop( 1 );
+
+		if( index != INVALID_STRING_INDEX )
+		{
+			LUA->PushNumber( k );
+			LUA->PushNumber( index );
+			LUA->SetTable( -4 );
+		}
+		else
+		{
+			LUA->PushNumber( ++failures );
+			LUA->PushNumber( k );
+			LUA->SetTable( -3 );
+		}
 	}
 
-	networkdict->Purge( );
+	// adding an existing string with userdata replaces its userdata
+	if( has_userdata )
+		Invalidate( udata );
 
-	LUA->PushBool( true );
-	return 1;
+	return 2;
 }
 
-LUA_FUNCTION_STATIC( GetTable )
+static bool SetStringInternal( CNetworkStringTable *stable, uint32_t index, const char *str )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
+	if( stable->FindStringIndex( str ) != INVALID_STRING_INDEX )
+		return false;
 
-	LUA->CreateTable( );
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr )
+		return false;
 
-	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
-	{
-		LUA->PushString( stable->GetString( i ) );
-		int32_t len = 0;
-		const char *userdata = static_cast<const char *>( stable->GetStringUserData( i, &len ) );
-		LUA->PushString( userdata, len );
-		LUA->SetTable( -3 );
-	}
+	CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	if( !dict.IsValidHandle( index ) )
+		return false;
 
-	return 1;
+	dict.ReplaceKey( index, str );
+	dict.Element( index ).m_nTickCreated = stable->m_nTickCount + 5;
+	changes::Notify( stable, static_cast<int32_t>( index ) );
+	return true;
 }
 
-LUA_FUNCTION_STATIC( GetStrings )
+LUA_FUNCTION_STATIC( SetString )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
-
-	LUA->CreateTable( );
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
 
-	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
-	{
-		LUA->PushNumber( i );
-		LUA->PushString( stable->GetString( i ) );
-		LUA->SetTable( -3 );
-	}
+	batch::Flush( LUA, stable );
+	const bool success = SetStringInternal(
+		stable, static_cast<uint32_t>( LUA->GetNumber( 2 ) ), LUA->GetString( 3 )
+	);
+	if( success )
+		Invalidate( udata );
 
+	LUA->PushBool( success );
 	return 1;
 }
 
-LUA_FUNCTION_STATIC( GetStringsUserData )
+LUA_FUNCTION_STATIC( SetStrings )
 {
-	INetworkStringTable *stable = Get( LUA, 1 );
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::TABLE );
+
+	const int32_t count = LUA->ObjLen( 2 );
+
+	batch::Flush( LUA, stable );
 
 	LUA->CreateTable( );
+	int32_t failures = 0;
+	int32_t successes = 0;
 
-	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
+	for( int32_t k = 1; k <= count; ++k )
 	{
-		LUA->PushNumber( i );
-		int32_t len = 0;
-		const char *userdata = static_cast<const char *>( stable->GetStringUserData( i, &len ) );
-		LUA->PushString( userdata, len );
-		LUA->SetTable( -3 );
+		bool success = false;
+
+		LUA->PushNumber( k );
+		LUA->RawGet( 2 );
+		LUA->PushNumber( k );
+		LUA->RawGet( 3 );
+		if( LUA->IsType( -2, GarrysMod::Lua::Type::NUMBER ) && LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+			success = SetStringInternal(
+				stable, static_cast<uint32_t>( LUA->GetNumber( -2 ) ), LUA->GetString( -1 )
+			);
+
+		LUA->Pop( 2 );
+
+		if( success )
+		{
+			++successes;
+		}
+		else
+		{
+			LUA->PushNumber( ++failures );
+			LUA->PushNumber( k );
+			LUA->SetTable( -3 );
+		}
 	}
 
-	return 1;
+	if( successes != 0 )
+		Invalidate( udata );
+
+	LUA->PushNumber( successes );
+	LUA->Insert( -2 );
+	return 2;
 }
 
-LUA_FUNCTION_STATIC( Dump )
+LUA_FUNCTION_STATIC( GetString )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	INetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
+
+	const int32_t index = static_cast<int32_t>( LUA->GetNumber( 2 ) );
+	if( PushCachedString( LUA, udata, index ) )
+		return 1;
+
+	const char *str = stable->GetString( index );
+	if( str == nullptr )
+		return 0;
+
+	LUA->PushString( str );
+	return 1;
+}
+
+static void SwapItems( CNetworkStringTableItem &a, CNetworkStringTableItem &b )
+{
+	// std::swap would go through a temporary whose destructor frees the userdata
+	std::swap( a.m_pUserData, b.m_pUserData );
+	std::swap( a.m_nUserDataLength, b.m_nUserDataLength );
+	std::swap( a.m_nTickChanged, b.m_nTickChanged );
+	std::swap( a.m_nTickCreated, b.m_nTickCreated );
+	std::swap( a.m_pChangeList, b.m_pChangeList );
+}
+
+static int32_t DeleteStringsInternal( CNetworkStringTable *stable, std::vector<uint32_t> &indices, bool unordered )
+{
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr )
+		return 0;
+
+	CNetworkStringDict::_StableHashtable_t &dict = static_cast<CNetworkStringDict::_StableHashtable_t &>( networkdict->m_Items );
+	uint32_t count = static_cast<uint32_t>( dict.Count( ) );
+
+	indices.erase( std::remove_if( indices.begin( ), indices.end( ), [count]( uint32_t index )
+	{
+		return index >= count;
+	} ), indices.end( ) );
+	std::sort( indices.begin( ), indices.end( ) );
+	indices.erase( std::unique( indices.begin( ), indices.end( ) ), indices.end( ) );
+	if( indices.empty( ) )
+		return 0;
+
+	auto &linkedlist = dict.GetLinkedList( );
+	auto move = [stable, &linkedlist]( uint32_t to, uint32_t from )
+	{
+		linkedlist[to].m_key = linkedlist[from].m_key;
+		SwapItems( linkedlist[to].m_value, linkedlist[from].m_value );
+
+		// the string now lives at another index, WriteUpdate only resends strings created after the ack
+		linkedlist[to].m_value.m_nTickChanged = stable->m_nTickCount;
+		linkedlist[to].m_value.m_nTickCreated = stable->m_nTickCount;
+	};
+
+	const uint32_t original_count = count;
+	if( unordered )
+	{
+		for( uint32_t index : indices )
+			changes::Notify( stable, static_cast<int32_t>( index ) );
+
+		// fill each hole with the last entry, from the highest index down so the
+		// entry being moved is never one that is also being deleted
+		for( auto it = indices.rbegin( ); it != indices.rend( ); ++it )
+		{
+			uint32_t index = *it, last = --count;
+			dict.UnlinkKey( index );
+			if( index != last )
+			{
+				dict.UnlinkKey( last );
+				move( index, last );
+				dict.LinkKey( index );
+			}
+
+			linkedlist.Remove( last );
+		}
+	}
+	else
+	{
+		// single compaction pass, only entries after the first deleted index move
+		uint32_t first = indices.front( ), write = first;
+		for( uint32_t k = first; k < count; ++k )
+			dict.UnlinkKey( k );
+
+		size_t next = 0;
+		for( uint32_t k = first; k < count; ++k )
+		{
+			if( next < indices.size( ) && indices[next] == k )
+			{
+				++next;
+				continue;
+			}
+
+			if( write != k )
+				move( write, k );
+
+			++write;
+		}
+
+		// free from the top so the lowest handle is reused first by the next insert
+		for( uint32_t k = count; k > write; --k )
+			linkedlist.Remove( k - 1 );
+
+		for( uint32_t k = first; k < write; ++k )
+			dict.LinkKey( k );
+
+		changes::Notify( stable, static_cast<int32_t>( first ), static_cast<int32_t>( write ) );
+		count = write;
+	}
+
+	// removed slots at the end are reported too, so subscribers can drop them
+	changes::Notify( stable, static_cast<int32_t>( count ), static_cast<int32_t>( original_count ) );
+
+	stable->m_nLastChangedTick = stable->m_nTickCount;
+	return static_cast<int32_t>( indices.size( ) );
+}
+
+LUA_FUNCTION_STATIC( DeleteString )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
+
+	std::vector<uint32_t> indices( 1, static_cast<uint32_t>( LUA->GetNumber( 2 ) ) );
+	batch::Flush( LUA, stable );
+	const bool success = DeleteStringsInternal( stable, indices, false ) != 0;
+	if( success )
+		Invalidate( udata );
+
+	LUA->PushBool( success );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( DeleteStrings )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+
+	const int32_t count = LUA->ObjLen( 2 );
+
+	std::vector<uint32_t> indices;
+	indices.reserve( count );
+	for( int32_t k = 1; k <= count; ++k )
+	{
+		LUA->PushNumber( k );
+		LUA->RawGet( 2 );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::NUMBER ) )
+			indices.push_back( static_cast<uint32_t>( LUA->GetNumber( -1 ) ) );
+
+		LUA->Pop( 1 );
+	}
+
+	batch::Flush( LUA, stable );
+	const int32_t deleted = DeleteStringsInternal( stable, indices, LUA->GetBool( 3 ) );
+	if( deleted != 0 )
+		Invalidate( udata );
+
+	LUA->PushNumber( deleted );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( SetStringUserData )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	INetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
+
+	unsigned int len = 0;
+	const char *userdata = LUA->GetString( 3, &len );
+	const int32_t index = static_cast<int32_t>( LUA->GetNumber( 2 ) );
+
+	// checked up front so staged writes can't fail later, when nobody is around to hear it
+	const char *error = nullptr;
+	if( stable->GetString( index ) == nullptr )
+		error = "invalid string index";
+	else if( !codec::Fits( stable, userdata, static_cast<int32_t>( len ) ) )
+		error = "userdata too big";
+
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	if( !batch::Stage( udata->stringtable, index, userdata, len ) )
+	{
+		codec::SetStringUserData( stable, index, userdata, static_cast<int32_t>( len ) );
+		InvalidateCachedUserData( udata, index );
+	}
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( SetStringsUserData )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	INetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::TABLE );
+
+	const int32_t count = LUA->ObjLen( 2 );
+
+	LUA->CreateTable( );
+	int32_t failures = 0;
+	int32_t successes = 0;
+
+	for( int32_t k = 1; k <= count; ++k )
+	{
+		bool success = false;
+
+		LUA->PushNumber( k );
+		LUA->RawGet( 2 );
+		LUA->PushNumber( k );
+		LUA->RawGet( 3 );
+		if( LUA->IsType( -2, GarrysMod::Lua::Type::NUMBER ) && LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+		{
+			const int32_t index = static_cast<int32_t>( LUA->GetNumber( -2 ) );
+			unsigned int len = 0;
+			const char *userdata = LUA->GetString( -1, &len );
+			if( stable->GetString( index ) != nullptr && codec::Fits( stable, userdata, static_cast<int32_t>( len ) ) )
+			{
+				if( !batch::Stage( udata->stringtable, index, userdata, len ) )
+				{
+					codec::SetStringUserData( stable, index, userdata, static_cast<int32_t>( len ) );
+					InvalidateCachedUserData( udata, index );
+				}
+
+				success = true;
+			}
+		}
+
+		LUA->Pop( 2 );
+
+		if( success )
+		{
+			++successes;
+		}
+		else
+		{
+			LUA->PushNumber( ++failures );
+			LUA->PushNumber( k );
+			LUA->SetTable( -3 );
+		}
+	}
+
+	LUA->PushNumber( successes );
+	LUA->Insert( -2 );
+	return 2;
+}
+
+LUA_FUNCTION_STATIC( SetUserDataCodec )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	bool enable = false;
+	if( !LUA->IsType( 2, GarrysMod::Lua::Type::NIL ) )
+	{
+		const char *name = LUA->CheckString( 2 );
+		enable = std::strcmp( name, "lzss" ) == 0;
+		if( !enable && std::strcmp( name, "none" ) != 0 )
+			LUA->ArgError( 2, "unknown codec, expected \"lzss\" or \"none\"" );
+	}
+
+	if( !codec::Enable( udata->stringtable, enable ) )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( "fixed size userdata can't be encoded" );
+		return 2;
+	}
+
+	Invalidate( udata );
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetUserDataCodec )
+{
+	LUA->PushString( codec::IsEnabled( Get( LUA, 1 ) ) ? "lzss" : "none" );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( SetBlob )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	const char *name = LUA->CheckString( 2 );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::STRING );
+	const bool is_server = GetRealmArgument( LUA, 4 );
+
+	unsigned int len = 0;
+	const char *data = LUA->GetString( 3, &len );
+
+	// staged writes would overwrite the chunks with older data on commit
+	batch::Flush( LUA, udata->stringtable );
+	int32_t written = 0;
+	const char *error = blob::Set( udata->stringtable, name, data, len, is_server, written );
+	if( written != 0 )
+		Invalidate( udata );
+
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushBool( true );
+	LUA->PushNumber( written );
+	return 2;
+}
+
+LUA_FUNCTION_STATIC( GetBlob )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	const char *name = LUA->CheckString( 2 );
+
+	batch::Flush( LUA, stable );
+	std::string data;
+	if( blob::Get( stable, name, data ) )
+		LUA->PushString( data.data( ), static_cast<unsigned int>( data.size( ) ) );
+	else
+		LUA->PushNil( );
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( BeginBatch )
+{
+	LUA->PushBool( batch::Begin( Get( LUA, 1 ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( CommitBatch )
+{
+	int32_t coalesced = 0, rejected = 0;
+	LUA->PushNumber( batch::Commit( LUA, Get( LUA, 1 ), coalesced, rejected ) );
+	LUA->PushNumber( coalesced );
+	LUA->PushNumber( rejected );
+	return 3;
+}
+
+LUA_FUNCTION_STATIC( GetStringUserData )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	INetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::NUMBER );
+
+	const int32_t index = static_cast<int32_t>( LUA->GetNumber( 2 ) );
+	if( batch::GetStaged( udata->stringtable, index ) != nullptr || !PushCachedUserData( LUA, udata, index ) )
+		PushStringUserData( LUA, stable, index );
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( FindStringIndex )
+{
+	LUA->PushNumber( Get( LUA, 1 )->FindStringIndex( LUA->CheckString( 2 ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( FindStringIndices )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	// client side items are referenced by negative indices
+	CNetworkStringDict *clientdict = LUA->GetBool( 3 ) ? stable->m_pItemsClientSide : nullptr;
+
+	const int32_t count = LUA->ObjLen( 2 );
+
+	LUA->CreateTable( );
+
+	for( int32_t k = 1; k <= count; ++k )
+	{
+		int32_t index = INVALID_STRING_INDEX;
+
+		LUA->PushNumber( k );
+		LUA->RawGet( 2 );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+		{
+			const char *str = LUA->GetString( -1 );
+
+			UtlHashHandle_t handle = networkdict != nullptr ? networkdict->m_Items.Find( str ) : CNetworkStringDict::StableHashtable_t::InvalidHandle( );
+			if( handle != CNetworkStringDict::StableHashtable_t::InvalidHandle( ) )
+			{
+				index = static_cast<int32_t>( handle );
+			}
+			else if( clientdict != nullptr )
+			{
+				handle = clientdict->m_Items.Find( str );
+				if( handle != CNetworkStringDict::StableHashtable_t::InvalidHandle( ) )
+					index = -static_cast<int32_t>( handle );
+			}
+		}
+
+		LUA->Pop( 1 );
+
+		if( index != INVALID_STRING_INDEX )
+		{
+			LUA->PushNumber( k );
+			LUA->PushNumber( index );
+			LUA->SetTable( -3 );
+		}
+	}
+
+	return 1;
+}
+
+// Compares the table against the list of strings at index through the table's own hashtable.
+// missing gets the listed strings the table lacks (caselessly deduplicated, pointing into
+// the Lua list) and extra the indices of the entries that aren't listed.
+static void DiffAgainstList( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stable, int32_t index,
+	std::vector<const char *> &missing, std::vector<uint32_t> &extra )
+{
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	const int32_t entries = networkdict != nullptr ? networkdict->Count( ) : 0;
+	std::vector<bool> listed( static_cast<size_t>( entries ), false );
+	std::unordered_set<std::string> missing_names;
+
+	const int32_t count = LUA->ObjLen( index );
+	for( int32_t k = 1; k <= count; ++k )
+	{
+		LUA->PushNumber( k );
+		LUA->RawGet( index );
+		if( LUA->IsType( -1, GarrysMod::Lua::Type::STRING ) )
+		{
+			const char *str = LUA->GetString( -1 );
+			UtlHashHandle_t handle = networkdict != nullptr ? networkdict->m_Items.Find( str ) : CNetworkStringDict::StableHashtable_t::InvalidHandle( );
+			if( handle != CNetworkStringDict::StableHashtable_t::InvalidHandle( ) )
+			{
+				listed[handle] = true;
+			}
+			else
+			{
+				std::string name( str );
+				std::transform( name.begin( ), name.end( ), name.begin( ), []( unsigned char c )
+				{
+					return static_cast<char>( std::tolower( c ) );
+				} );
+
+				if( missing_names.insert( std::move( name ) ).second )
+					missing.push_back( str );
+			}
+		}
+
+		LUA->Pop( 1 );
+	}
+
+	for( int32_t i = 0; i < entries; ++i )
+		if( !listed[i] )
+			extra.push_back( static_cast<uint32_t>( i ) );
+}
+
+LUA_FUNCTION_STATIC( Diff )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+
+	std::vector<const char *> missing;
+	std::vector<uint32_t> extra;
+	DiffAgainstList( LUA, stable, 2, missing, extra );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < missing.size( ); ++k )
+	{
+		LUA->PushNumber( static_cast<double>( k + 1 ) );
+		LUA->PushString( missing[k] );
+		LUA->SetTable( -3 );
+	}
+
+	LUA->CreateTable( );
+	for( uint32_t index : extra )
+	{
+		LUA->PushNumber( index );
+		LUA->PushString( stable->GetString( static_cast<int32_t>( index ) ) );
+		LUA->SetTable( -3 );
+	}
+
+	return 2;
+}
+
+LUA_FUNCTION_STATIC( SyncTo )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	LUA->CheckType( 2, GarrysMod::Lua::Type::TABLE );
+	const bool is_server = GetRealmArgument( LUA, 3 );
+	const bool unordered = LUA->GetBool( 4 );
+
+	std::vector<const char *> missing;
+	std::vector<uint32_t> extra;
+	DiffAgainstList( LUA, stable, 2, missing, extra );
+
+	// delete first so the adds can reuse the freed slots
+	batch::Flush( LUA, stable );
+	const int32_t deleted = DeleteStringsInternal( stable, extra, unordered );
+
+	int32_t added = 0;
+	for( const char *str : missing )
+		if( stable->AddString( is_server, str ) != INVALID_STRING_INDEX )
+			++added;
+
+	if( deleted != 0 )
+		Invalidate( udata );
+
+	LUA->PushNumber( added );
+	LUA->PushNumber( deleted );
+	return 2;
+}
+
+LUA_FUNCTION_STATIC( SetAllowClientSideAddString )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+	LUA->CheckType( 2, GarrysMod::Lua::Type::BOOL );
+
+	stringtablecontainer::stcinternal->SetAllowClientSideAddString( stable, LUA->GetBool( 2 ) );
+	return 0;
+}
+
+LUA_FUNCTION_STATIC( DeleteAllStrings )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr || networkdict->Count( ) == 0 )
+	{
+		LUA->PushBool( false );
+		return 1;
+	}
+
+	batch::Flush( LUA, stable );
+	changes::Notify( stable, 0, networkdict->Count( ) );
+	networkdict->Purge( );
+	Invalidate( udata );
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetTable )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+
+	LUA->CreateTable( );
+
+	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
+	{
+		LUA->PushString( stable->GetString( i ) );
+		PushStringUserData( LUA, stable, i );
+		LUA->SetTable( -3 );
+	}
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetStrings )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+
+	LUA->CreateTable( );
+
+	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
+	{
+		LUA->PushNumber( i );
+		LUA->PushString( stable->GetString( i ) );
+		LUA->SetTable( -3 );
+	}
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetStringsUserData )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+
+	LUA->CreateTable( );
+
+	for( int32_t i = 0; i < stable->GetNumStrings( ); ++i )
+	{
+		LUA->PushNumber( i );
+		PushStringUserData( LUA, stable, i );
+		LUA->SetTable( -3 );
+	}
+
+	return 1;
+}
+
+// Clamps a (start, count) pair from the Lua stack to the valid range of a stringtable
+static void GetRangeArguments( GarrysMod::Lua::ILuaBase *LUA, INetworkStringTable *stable, int32_t &start, int32_t &end )
+{
+	const int32_t numstrings = stable->GetNumStrings( );
+	start = std::max( OptionalInteger( LUA, 2, 0 ), 0 );
+	const int32_t count = std::max( OptionalInteger( LUA, 3, numstrings ), 0 );
+	end = static_cast<int32_t>( std::min<int64_t>( static_cast<int64_t>( start ) + count, numstrings ) );
+}
+
+LUA_FUNCTION_STATIC( EntriesIterator )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+
+	const int32_t index = static_cast<int32_t>( LUA->GetNumber( 2 ) ) + 1;
+	const int32_t end = static_cast<int32_t>( LUA->GetNumber( lua_upvalueindex( 1 ) ) );
+	if( index >= end || index >= stable->GetNumStrings( ) )
+		return 0;
+
+	LUA->PushNumber( index );
+	LUA->PushString( stable->GetString( index ) );
+	PushStringUserData( LUA, stable, index );
+	return 3;
+}
+
+LUA_FUNCTION_STATIC( Entries )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+
+	int32_t start = 0, end = 0;
+	GetRangeArguments( LUA, stable, start, end );
+
+	LUA->PushNumber( end );
+	LUA->PushCClosure( EntriesIterator, 1 );
+	LUA->Push( 1 );
+	LUA->PushNumber( start - 1 );
+	return 3;
+}
+
+LUA_FUNCTION_STATIC( GetRange )
+{
+	INetworkStringTable *stable = Get( LUA, 1 );
+	const bool with_userdata = LUA->GetBool( 4 );
+
+	int32_t start = 0, end = 0;
+	GetRangeArguments( LUA, stable, start, end );
+
+	LUA->CreateTable( );
+	if( with_userdata )
+		LUA->CreateTable( );
+
+	for( int32_t i = start; i < end; ++i )
+	{
+		LUA->PushNumber( i );
+		LUA->PushString( stable->GetString( i ) );
+		LUA->SetTable( with_userdata ? -4 : -3 );
+
+		if( with_userdata )
+		{
+			LUA->PushNumber( i );
+			PushStringUserData( LUA, stable, i );
+			LUA->SetTable( -3 );
+		}
+	}
+
+	return with_userdata ? 2 : 1;
+}
+
+LUA_FUNCTION_STATIC( EnableCache )
 {
-	Get( LUA, 1 )->Dump( );
+	Container *udata = GetContainer( LUA, 1 );
+	LUA->CheckType( 2, GarrysMod::Lua::Type::BOOL );
+
+	if( !LUA->GetBool( 2 ) )
+	{
+		DestroyCache( LUA, udata );
+		return 0;
+	}
+
+	if( udata->cache != nullptr )
+		return 0;
+
+	Cache *cache = new Cache;
+
+	LUA->CreateTable( );
+	cache->strings = LUA->ReferenceCreate( );
+
+	LUA->CreateTable( );
+	cache->userdata = LUA->ReferenceCreate( );
+
+	udata->cache = cache;
 	return 0;
 }
 
+LUA_FUNCTION_STATIC( GetCacheStats )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	if( udata->cache == nullptr )
+		return 0;
+
+	LUA->PushNumber( static_cast<double>( udata->cache->hits ) );
+	LUA->PushNumber( static_cast<double>( udata->cache->misses ) );
+	return 2;
+}
+
+static searchindex::Index &GetSearchIndex( Container *udata )
+{
+	if( udata->search == nullptr )
+		udata->search = new searchindex::Index;
+
+	udata->search->Update( udata->stringtable );
+	return *udata->search;
+}
+
+static void PushIndexedStrings( GarrysMod::Lua::ILuaBase *LUA, INetworkStringTable *stable, const std::vector<int32_t> &indices )
+{
+	LUA->CreateTable( );
+
+	for( int32_t index : indices )
+	{
+		LUA->PushNumber( index );
+		LUA->PushString( stable->GetString( index ) );
+		LUA->SetTable( -3 );
+	}
+}
+
+LUA_FUNCTION_STATIC( FindByPrefix )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	const char *prefix = LUA->CheckString( 2 );
+
+	std::vector<int32_t> indices;
+	GetSearchIndex( udata ).FindByPrefix( prefix, indices );
+	PushIndexedStrings( LUA, udata->stringtable, indices );
+	return 1;
+}
+
+// Literal, caseless substring search, Lua pattern characters aren't special
+LUA_FUNCTION_STATIC( FindMatching )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	const char *substring = LUA->CheckString( 2 );
+
+	std::vector<int32_t> indices;
+	GetSearchIndex( udata ).FindMatching( substring, indices );
+	PushIndexedStrings( LUA, udata->stringtable, indices );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( Snapshot )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+
+	const char *error = stringtablefile::Write( LUA->CheckString( 2 ), &stable, 1 );
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+// Only the file's entry for this table (by current or original name) is read. Entries are
+// added on top of the table's current contents, restoring merges instead of replacing.
+LUA_FUNCTION_STATIC( Restore )
+{
+	Container *udata = GetContainer( LUA, 1 );
+	CNetworkStringTable *stable = udata->stringtable;
+	const char *path = LUA->CheckString( 2 );
+	const bool is_server = GetRealmArgument( LUA, 3 );
+
+	batch::Flush( LUA, stable );
+	int32_t restored = 0;
+	bool found = false;
+	const char *error = stringtablefile::Read( path, is_server, [udata, stable, &found]( const char *name )
+	{
+		if( V_stricmp( name, stable->GetTableName( ) ) != 0 && V_stricmp( name, udata->name_original ) != 0 )
+			return static_cast<CNetworkStringTable *>( nullptr );
+
+		found = true;
+		return stable;
+	}, restored );
+	Invalidate( udata );
+
+	if( error == nullptr && !found )
+		error = "file has no entry for this stringtable";
+
+	if( error != nullptr )
+	{
+		LUA->PushNil( );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushNumber( restored );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( LoadManifest )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	const char *path = LUA->CheckString( 2 );
+	LUA->CheckType( 3, GarrysMod::Lua::Type::FUNCTION );
+	const int32_t batch_size = std::max( OptionalInteger( LUA, 4, 256 ), 1 );
+
+	if( !stringtablefile::IsValidPath( path ) )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( "invalid path" );
+		return 2;
+	}
+
+	const bool is_server = GetRealmArgument( LUA, 5 );
+
+	LUA->Push( 3 );
+	manifest::Load( stable, path, LUA->ReferenceCreate( ), batch_size, is_server );
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( OnChanged )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+
+	if( LUA->IsType( 2, GarrysMod::Lua::Type::NIL ) )
+	{
+		LUA->PushBool( changes::Unsubscribe( LUA, stable ) );
+		return 1;
+	}
+
+	LUA->CheckType( 2, GarrysMod::Lua::Type::FUNCTION );
+	LUA->Push( 2 );
+	changes::Subscribe( LUA, stable, LUA->ReferenceCreate( ) );
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( TrimHistory )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	const int32_t tick = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+
+	LUA->PushNumber( static_cast<double>( history::TrimOlderThan( stable, tick ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( SetHistoryLimit )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	const int32_t limit = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+
+	history::SetLimit( stable, limit );
+	LUA->PushNumber( limit > 0 ? static_cast<double>( history::TrimToLimit( stable, limit ) ) : 0.0 );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( CreateSnapshot )
+{
+	tablesnapshot::Push( LUA, tablesnapshot::Snapshot::Create( Get( LUA, 1 ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( ValidateFiles )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	LUA->CheckType( 2, GarrysMod::Lua::Type::FUNCTION );
+
+	if( !stable->m_bIsFilenames )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( "not a filenames stringtable" );
+		return 2;
+	}
+
+	LUA->Push( 2 );
+	filevalidation::Validate( stable, LUA->ReferenceCreate( ) );
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetHashStats )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+
+	int32_t buckets = 0, entries = 0, max_probe = 0;
+	int64_t total_probe = 0;
+	std::vector<int32_t> histogram( 1, 0 );
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict != nullptr )
+	{
+		CNetworkStringDict::_StableHashtable_t &dict = static_cast<CNetworkStringDict::_StableHashtable_t &>( networkdict->m_Items );
+		buckets = dict.GetNumBuckets( );
+		entries = dict.Count( );
+
+		// open addressing with linear probing, a lookup walks from the home slot to the key
+		dict.ForEachProbeDistance( [&]( int32_t distance )
+		{
+			if( distance >= static_cast<int32_t>( histogram.size( ) ) )
+				histogram.resize( static_cast<size_t>( distance ) + 1, 0 );
+
+			++histogram[distance];
+			max_probe = std::max( max_probe, distance );
+			total_probe += distance;
+		} );
+	}
+
+	LUA->CreateTable( );
+
+	LUA->PushNumber( buckets );
+	LUA->SetField( -2, "buckets" );
+
+	LUA->PushNumber( entries );
+	LUA->SetField( -2, "entries" );
+
+	LUA->PushNumber( buckets != 0 ? static_cast<double>( entries ) / buckets : 0.0 );
+	LUA->SetField( -2, "load_factor" );
+
+	LUA->PushNumber( max_probe );
+	LUA->SetField( -2, "max_probe" );
+
+	LUA->PushNumber( entries != 0 ? static_cast<double>( total_probe ) / entries : 0.0 );
+	LUA->SetField( -2, "avg_probe" );
+
+	// probe distance to number of keys at it
+	LUA->CreateTable( );
+	for( size_t k = 0; k < histogram.size( ); ++k )
+	{
+		LUA->PushNumber( static_cast<double>( k ) );
+		LUA->PushNumber( histogram[k] );
+		LUA->SetTable( -3 );
+	}
+
+	LUA->SetField( -2, "histogram" );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetHandle )
+{
+	// stringtable_t * for stringtableapi.h, through ffi.cast
+	LUA->PushUserdata( static_cast<INetworkStringTable *>( Get( LUA, 1 ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetMemoryUsage )
+{
+	memoryusage::Push( LUA, memoryusage::Get( Get( LUA, 1 ) ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( Dump )
+{
+	CNetworkStringTable *stable = Get( LUA, 1 );
+	if( LUA->IsType( 2, GarrysMod::Lua::Type::NONE ) || LUA->IsType( 2, GarrysMod::Lua::Type::NIL ) )
+	{
+		stable->Dump( );
+		return 0;
+	}
+
+	const char *error = dumpfile::Start( LUA, LUA->CheckString( 2 ), std::vector<CNetworkStringTable *>( 1, stable ), 3 );
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushBool( true );
+	return 1;
+}
+
 LUA_FUNCTION_STATIC( Lock )
 {
 	CNetworkStringTable *stable = Get( LUA, 1 );
@@ -458,70 +1709,169 @@ void Initialize( GarrysMod::Lua::ILuaBase *LUA )
 	LUA->PushCFunction( newindex );
 	LUA->SetField( -2, "__newindex" );
 
-	LUA->PushCFunction( SetName );
+	stats::PushCFunction( LUA, SetName, "stringtable:SetName" );
 	LUA->SetField( -2, "SetName" );
 
-	LUA->PushCFunction( GetName );
+	stats::PushCFunction( LUA, GetName, "stringtable:GetName" );
 	LUA->SetField( -2, "GetName" );
 
-	LUA->PushCFunction( GetID );
+	stats::PushCFunction( LUA, GetID, "stringtable:GetID" );
 	LUA->SetField( -2, "GetID" );
 
-	LUA->PushCFunction( GetNumStrings );
+	stats::PushCFunction( LUA, GetNumStrings, "stringtable:GetNumStrings" );
 	LUA->SetField( -2, "GetNumStrings" );
 
-	LUA->PushCFunction( GetMaxStrings );
+	stats::PushCFunction( LUA, GetMaxStrings, "stringtable:GetMaxStrings" );
 	LUA->SetField( -2, "GetMaxStrings" );
 
-	LUA->PushCFunction( GetEntryBits );
+	stats::PushCFunction( LUA, GetEntryBits, "stringtable:GetEntryBits" );
 	LUA->SetField( -2, "GetEntryBits" );
 
-	LUA->PushCFunction( SetTick );
+	stats::PushCFunction( LUA, SetTick, "stringtable:SetTick" );
 	LUA->SetField( -2, "SetTick" );
 
-	LUA->PushCFunction( ChangedSinceTick );
+	stats::PushCFunction( LUA, ChangedSinceTick, "stringtable:ChangedSinceTick" );
 	LUA->SetField( -2, "ChangedSinceTick" );
 
-	LUA->PushCFunction( AddString );
+	stats::PushCFunction( LUA, CountChangedSince, "stringtable:CountChangedSince" );
+	LUA->SetField( -2, "CountChangedSince" );
+
+	stats::PushCFunction( LUA, GetChangedSince, "stringtable:GetChangedSince" );
+	LUA->SetField( -2, "GetChangedSince" );
+
+	stats::PushCFunction( LUA, EstimateUpdateBits, "stringtable:EstimateUpdateBits" );
+	LUA->SetField( -2, "EstimateUpdateBits" );
+
+	stats::PushCFunction( LUA, AddString, "stringtable:AddString" );
 	LUA->SetField( -2, "AddString" );
 
-	LUA->PushCFunction( SetString );
+	stats::PushCFunction( LUA, AddStrings, "stringtable:AddStrings" );
+	LUA->SetField( -2, "AddStrings" );
+
+	stats::PushCFunction( LUA, SetString, "stringtable:SetString" );
 	LUA->SetField( -2, "SetString" );
 
-	LUA->PushCFunction( GetString );
+	stats::PushCFunction( LUA, SetStrings, "stringtable:SetStrings" );
+	LUA->SetField( -2, "SetStrings" );
+
+	stats::PushCFunction( LUA, GetString, "stringtable:GetString" );
 	LUA->SetField( -2, "GetString" );
 
-	LUA->PushCFunction( DeleteString );
+	stats::PushCFunction( LUA, DeleteString, "stringtable:DeleteString" );
 	LUA->SetField( -2, "DeleteString" );
 
-	LUA->PushCFunction( SetStringUserData );
+	stats::PushCFunction( LUA, DeleteStrings, "stringtable:DeleteStrings" );
+	LUA->SetField( -2, "DeleteStrings" );
+
+	stats::PushCFunction( LUA, SetStringUserData, "stringtable:SetStringUserData" );
 	LUA->SetField( -2, "SetStringUserData" );
 
-	LUA->PushCFunction( GetStringUserData );
+	stats::PushCFunction( LUA, SetStringsUserData, "stringtable:SetStringsUserData" );
+	LUA->SetField( -2, "SetStringsUserData" );
+
+	stats::PushCFunction( LUA, SetUserDataCodec, "stringtable:SetUserDataCodec" );
+	LUA->SetField( -2, "SetUserDataCodec" );
+
+	stats::PushCFunction( LUA, GetUserDataCodec, "stringtable:GetUserDataCodec" );
+	LUA->SetField( -2, "GetUserDataCodec" );
+
+	stats::PushCFunction( LUA, SetBlob, "stringtable:SetBlob" );
+	LUA->SetField( -2, "SetBlob" );
+
+	stats::PushCFunction( LUA, GetBlob, "stringtable:GetBlob" );
+	LUA->SetField( -2, "GetBlob" );
+
+	stats::PushCFunction( LUA, BeginBatch, "stringtable:BeginBatch" );
+	LUA->SetField( -2, "BeginBatch" );
+
+	stats::PushCFunction( LUA, CommitBatch, "stringtable:CommitBatch" );
+	LUA->SetField( -2, "CommitBatch" );
+
+	stats::PushCFunction( LUA, GetStringUserData, "stringtable:GetStringUserData" );
 	LUA->SetField( -2, "GetStringUserData" );
 
-	LUA->PushCFunction( FindStringIndex );
+	stats::PushCFunction( LUA, FindStringIndex, "stringtable:FindStringIndex" );
 	LUA->SetField( -2, "FindStringIndex" );
 
-	LUA->PushCFunction( SetAllowClientSideAddString );
+	stats::PushCFunction( LUA, FindStringIndices, "stringtable:FindStringIndices" );
+	LUA->SetField( -2, "FindStringIndices" );
+
+	stats::PushCFunction( LUA, Diff, "stringtable:Diff" );
+	LUA->SetField( -2, "Diff" );
+
+	stats::PushCFunction( LUA, SyncTo, "stringtable:SyncTo" );
+	LUA->SetField( -2, "SyncTo" );
+
+	stats::PushCFunction( LUA, SetAllowClientSideAddString, "stringtable:SetAllowClientSideAddString" );
 	LUA->SetField( -2, "SetAllowClientSideAddString" );
 
-	LUA->PushCFunction( DeleteAllStrings );
+	stats::PushCFunction( LUA, DeleteAllStrings, "stringtable:DeleteAllStrings" );
 	LUA->SetField( -2, "DeleteAllStrings" );
 
-	LUA->PushCFunction( GetTable );
+	stats::PushCFunction( LUA, GetTable, "stringtable:GetTable" );
 	LUA->SetField( -2, "GetTable" );
 
-	LUA->PushCFunction( GetStrings );
+	stats::PushCFunction( LUA, GetStrings, "stringtable:GetStrings" );
 	LUA->SetField( -2, "GetStrings" );
 
-	LUA->PushCFunction( GetStringsUserData );
+	stats::PushCFunction( LUA, GetStringsUserData, "stringtable:GetStringsUserData" );
 	LUA->SetField( -2, "GetStringsUserData" );
 
-	LUA->PushCFunction( Dump );
+	stats::PushCFunction( LUA, Entries, "stringtable:Entries" );
+	LUA->SetField( -2, "Entries" );
+
+	stats::PushCFunction( LUA, GetRange, "stringtable:GetRange" );
+	LUA->SetField( -2, "GetRange" );
+
+	stats::PushCFunction( LUA, EnableCache, "stringtable:EnableCache" );
+	LUA->SetField( -2, "EnableCache" );
+
+	stats::PushCFunction( LUA, GetCacheStats, "stringtable:GetCacheStats" );
+	LUA->SetField( -2, "GetCacheStats" );
+
+	stats::PushCFunction( LUA, FindByPrefix, "stringtable:FindByPrefix" );
+	LUA->SetField( -2, "FindByPrefix" );
+
+	stats::PushCFunction( LUA, FindMatching, "stringtable:FindMatching" );
+	LUA->SetField( -2, "FindMatching" );
+
+	stats::PushCFunction( LUA, Snapshot, "stringtable:Snapshot" );
+	LUA->SetField( -2, "Snapshot" );
+
+	stats::PushCFunction( LUA, Restore, "stringtable:Restore" );
+	LUA->SetField( -2, "Restore" );
+
+	stats::PushCFunction( LUA, LoadManifest, "stringtable:LoadManifest" );
+	LUA->SetField( -2, "LoadManifest" );
+
+	stats::PushCFunction( LUA, OnChanged, "stringtable:OnChanged" );
+	LUA->SetField( -2, "OnChanged" );
+
+	stats::PushCFunction( LUA, TrimHistory, "stringtable:TrimHistory" );
+	LUA->SetField( -2, "TrimHistory" );
+
+	stats::PushCFunction( LUA, SetHistoryLimit, "stringtable:SetHistoryLimit" );
+	LUA->SetField( -2, "SetHistoryLimit" );
+
+	stats::PushCFunction( LUA, CreateSnapshot, "stringtable:CreateSnapshot" );
+	LUA->SetField( -2, "CreateSnapshot" );
+
+	stats::PushCFunction( LUA, ValidateFiles, "stringtable:ValidateFiles" );
+	LUA->SetField( -2, "ValidateFiles" );
+
+	stats::PushCFunction( LUA, GetHashStats, "stringtable:GetHashStats" );
+	LUA->SetField( -2, "GetHashStats" );
+
+	stats::PushCFunction( LUA, GetHandle, "stringtable:GetHandle" );
+	LUA->SetField( -2, "GetHandle" );
+
+	stats::PushCFunction( LUA, GetMemoryUsage, "stringtable:GetMemoryUsage" );
+	LUA->SetField( -2, "GetMemoryUsage" );
+
+	stats::PushCFunction( LUA, Dump, "stringtable:Dump" );
 	LUA->SetField( -2, "Dump" );
 
-	LUA->PushCFunction( Lock );
+	stats::PushCFunction( LUA, Lock, "stringtable:Lock" );
 	LUA->SetField( -2, "Lock" );
 
 	LUA->Pop( 1 );
@@ -8,6 +8,8 @@ namespace GarrysMod
 	}
 }
 
+#include <cstdint>
+
 class CNetworkStringTable;
 
 namespace stringtable
@@ -16,5 +18,10 @@ namespace stringtable
 void Initialize( GarrysMod::Lua::ILuaBase *LUA );
 void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
 void Push( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable );
+// Returns nullptr instead of erroring when the value isn't a valid stringtable
+CNetworkStringTable *Test( GarrysMod::Lua::ILuaBase *LUA, int32_t index );
+void Invalidate( GarrysMod::Lua::ILuaBase *LUA, CNetworkStringTable *stringtable );
+// Optional isServer argument of AddString-like functions, defaults to the running realm
+bool GetRealmArgument( GarrysMod::Lua::ILuaBase *LUA, int32_t index );
 
 }
@@ -0,0 +1,113 @@
+#include "stringtableapi.h"
+#include "stringtablecontainer.hpp"
+#include "tablesnapshot.hpp"
+#include "codec.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <cstring>
+#include <string>
+
+static INetworkStringTable *GetTable( stringtable_t *handle )
+{
+	return reinterpret_cast<INetworkStringTable *>( handle );
+}
+
+static const tablesnapshot::Snapshot *GetSnapshot( stringtable_snapshot_t *snapshot )
+{
+	return reinterpret_cast<const tablesnapshot::Snapshot *>( snapshot );
+}
+
+static bool IsValidIndex( INetworkStringTable *stable, int index )
+{
+	return index >= 0 && index < stable->GetNumStrings( );
+}
+
+stringtable_t *stringtable_from_id( int id )
+{
+	if( stringtablecontainer::stcinternal == nullptr ||
+		id < 0 || id >= stringtablecontainer::stcinternal->GetNumTables( ) )
+		return nullptr;
+
+	return reinterpret_cast<stringtable_t *>( stringtablecontainer::stcinternal->GetTable( id ) );
+}
+
+int stringtable_count( stringtable_t *handle )
+{
+	return GetTable( handle )->GetNumStrings( );
+}
+
+const char *stringtable_get_string( stringtable_t *handle, int index, int *length )
+{
+	INetworkStringTable *stable = GetTable( handle );
+	if( !IsValidIndex( stable, index ) )
+		return nullptr;
+
+	const char *str = stable->GetString( index );
+	if( length != nullptr )
+		*length = str != nullptr ? static_cast<int>( std::strlen( str ) ) : 0;
+
+	return str;
+}
+
+const void *stringtable_get_userdata( stringtable_t *handle, int index, int *length )
+{
+	INetworkStringTable *stable = GetTable( handle );
+	if( !IsValidIndex( stable, index ) )
+		return nullptr;
+
+	// decoded userdata lives in this buffer until the next call
+	static std::string buffer;
+	int32_t len = 0;
+	const void *userdata = codec::GetStringUserData( stable, index, len, buffer );
+	if( length != nullptr )
+		*length = userdata != nullptr ? len : 0;
+
+	return userdata;
+}
+
+int stringtable_find( stringtable_t *handle, const char *string )
+{
+	const int index = GetTable( handle )->FindStringIndex( string );
+	return index != INVALID_STRING_INDEX ? index : -1;
+}
+
+stringtable_snapshot_t *stringtable_snapshot_create( stringtable_t *handle )
+{
+	CNetworkStringTable *stable = static_cast<CNetworkStringTable *>( GetTable( handle ) );
+	return reinterpret_cast<stringtable_snapshot_t *>( tablesnapshot::Snapshot::Create( stable ) );
+}
+
+void stringtable_snapshot_addref( stringtable_snapshot_t *snapshot )
+{
+	GetSnapshot( snapshot )->AddRef( );
+}
+
+void stringtable_snapshot_release( stringtable_snapshot_t *snapshot )
+{
+	GetSnapshot( snapshot )->Release( );
+}
+
+int stringtable_snapshot_count( stringtable_snapshot_t *snapshot )
+{
+	return GetSnapshot( snapshot )->GetCount( );
+}
+
+int stringtable_snapshot_tick( stringtable_snapshot_t *snapshot )
+{
+	return GetSnapshot( snapshot )->GetTick( );
+}
+
+const char *stringtable_snapshot_name( stringtable_snapshot_t *snapshot )
+{
+	return GetSnapshot( snapshot )->GetName( );
+}
+
+const char *stringtable_snapshot_get_string( stringtable_snapshot_t *snapshot, int index, int *length )
+{
+	return GetSnapshot( snapshot )->GetString( index, length );
+}
+
+const void *stringtable_snapshot_get_userdata( stringtable_snapshot_t *snapshot, int index, int *length )
+{
+	return GetSnapshot( snapshot )->GetUserData( index, length );
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+ * Plain C API over stringtables, meant to be called from LuaJIT's FFI so hot read
+ * loops don't go through lua_CFunctions (which abort traces). Handles come from
+ * tbl:GetHandle() or stringtable_from_id and are only valid until the engine
+ * recreates its tables (level change); re-resolve them by ID when in doubt.
+ * The stringtable_t functions are only safe to call from the main thread.
+ *
+ * readme.md has these declarations without STRINGTABLE_API, ready for ffi.cdef.
+ *
+ * Snapshots are immutable copies of a table that any thread can read without
+ * locking. They are reference counted, the last release frees them.
+ */
+
+#if defined _WIN32
+	#define STRINGTABLE_API __declspec( dllexport )
+#else
+	#define STRINGTABLE_API __attribute__( ( visibility( "default" ) ) )
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef struct stringtable_t stringtable_t;
+
+/* Returns NULL when there's no table with this ID */
+STRINGTABLE_API stringtable_t *stringtable_from_id( int id );
+
+STRINGTABLE_API int stringtable_count( stringtable_t *handle );
+
+/*
+ * Both return NULL for invalid indices, length is optional. Userdata of tables using the
+ * userdata codec is decoded into a buffer that the next stringtable_get_userdata reuses.
+ */
+STRINGTABLE_API const char *stringtable_get_string( stringtable_t *handle, int index, int *length );
+STRINGTABLE_API const void *stringtable_get_userdata( stringtable_t *handle, int index, int *length );
+
+/* Returns -1 when the string isn't in the table */
+STRINGTABLE_API int stringtable_find( stringtable_t *handle, const char *string );
+
+typedef struct stringtable_snapshot_t stringtable_snapshot_t;
+
+/* Main thread only, the snapshot starts with one reference */
+STRINGTABLE_API stringtable_snapshot_t *stringtable_snapshot_create( stringtable_t *handle );
+
+STRINGTABLE_API void stringtable_snapshot_addref( stringtable_snapshot_t *snapshot );
+STRINGTABLE_API void stringtable_snapshot_release( stringtable_snapshot_t *snapshot );
+
+STRINGTABLE_API int stringtable_snapshot_count( stringtable_snapshot_t *snapshot );
+STRINGTABLE_API int stringtable_snapshot_tick( stringtable_snapshot_t *snapshot );
+STRINGTABLE_API const char *stringtable_snapshot_name( stringtable_snapshot_t *snapshot );
+
+/* Both return NULL for invalid indices, length is optional */
+STRINGTABLE_API const char *stringtable_snapshot_get_string( stringtable_snapshot_t *snapshot, int index, int *length );
+STRINGTABLE_API const void *stringtable_snapshot_get_userdata( stringtable_snapshot_t *snapshot, int index, int *length );
+
+#ifdef __cplusplus
+}
+#endif
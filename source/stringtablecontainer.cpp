@@ -1,11 +1,18 @@
 #include "stringtablecontainer.hpp"
 #include "stringtable.hpp"
+#include "stringtablefile.hpp"
+#include "batch.hpp"
+#include "dumpfile.hpp"
+#include "memoryusage.hpp"
+#include "stats.hpp"
 #include "hackednetworkstringtable.h"
 
 #include <GarrysMod/Lua/Interface.h>
 #include <GarrysMod/InterfacePointers.hpp>
+#include <tier1/strtools.h>
 
 #include <cstdint>
+#include <vector>
 
 void CNetworkStringTableContainer::Dump( )
 {
@@ -31,11 +38,90 @@ CNetworkStringTableContainer *stcinternal = nullptr;
 
 static const char *table_name = "stringtable";
 
+struct CachedTable
+{
+	CNetworkStringTable *stringtable;
+	int32_t id;
+};
+
+// Caseless name to table index, same hashing as the engine's own string dictionaries
+typedef CUtlStableHashtable<
+	CUtlConstString,
+	CachedTable,
+	CaselessStringHashFunctor,
+	UTLConstStringCaselessStringEqualFunctor<char>,
+	uint16,
+	const char *
+> NameIndex_t;
+
+static NameIndex_t name_index;
+static int32_t name_index_count = -1;
+
+void InvalidateNameIndex( )
+{
+	name_index_count = -1;
+}
+
+bool IsAlive( const INetworkStringTable *stable, int32_t id )
+{
+	return stcinternal->GetTable( id ) == stable;
+}
+
+static void ClearNameIndex( )
+{
+	name_index.RemoveAll( );
+	name_index_count = -1;
+}
+
+static void BuildNameIndex( )
+{
+	ClearNameIndex( );
+
+	const int32_t count = stcinternal->GetNumTables( );
+	for( int32_t i = 0; i < count; ++i )
+	{
+		CNetworkStringTable *stable = static_cast<CNetworkStringTable *>( stcinternal->GetTable( i ) );
+		if( stable == nullptr )
+			continue;
+
+		// first table wins on duplicate names, like FindTable
+		const char *name = stable->GetTableName( );
+		if( name_index.Find( name ) != name_index.InvalidHandle( ) )
+			continue;
+
+		CachedTable &entry = name_index.Element( name_index.Insert( name ) );
+		entry.stringtable = stable;
+		entry.id = i;
+	}
+
+	name_index_count = count;
+}
+
+static CachedTable *FindCachedTable( const char *name )
+{
+	if( name_index_count != stcinternal->GetNumTables( ) )
+		BuildNameIndex( );
+
+	UtlHashHandle_t k = name_index.Find( name );
+	if( k == name_index.InvalidHandle( ) )
+		return nullptr;
+
+	// a recreated table can land at the same address under another name
+	CachedTable *entry = &name_index.Element( k );
+	if( IsAlive( entry->stringtable, entry->id ) &&
+		V_stricmp( entry->stringtable->GetTableName( ), name ) == 0 )
+		return entry;
+
+	// tables were recreated without the count changing (level change)
+	BuildNameIndex( );
+	k = name_index.Find( name );
+	return k != name_index.InvalidHandle( ) ? &name_index.Element( k ) : nullptr;
+}
+
 LUA_FUNCTION_STATIC( Find )
 {
-	stringtable::Push( LUA, static_cast<CNetworkStringTable *>(
-		stcinternal->FindTable( LUA->CheckString( 1 ) )
-	) );
+	CachedTable *entry = FindCachedTable( LUA->CheckString( 1 ) );
+	stringtable::Push( LUA, entry != nullptr ? entry->stringtable : nullptr );
 	return 1;
 }
 
@@ -53,6 +139,43 @@ LUA_FUNCTION_STATIC( GetCount )
 	return 1;
 }
 
+// Largest table CreateStringTable accepts, entry indices have to stay below INVALID_STRING_INDEX
+static const int32_t max_created_entries = 32768;
+
+LUA_FUNCTION_STATIC( Create )
+{
+	const char *name = LUA->CheckString( 1 );
+	const int32_t maxentries = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+	const bool is_filenames = LUA->GetBool( 3 );
+
+	// the engine errors out (or crashes) on all of these instead of failing the call
+	const char *error = nullptr;
+	if( maxentries <= 0 || maxentries > max_created_entries || ( maxentries & ( maxentries - 1 ) ) != 0 )
+		error = "maximum entries must be a power of two up to 32768";
+	else if( stcinternal->FindTable( name ) != nullptr )
+		error = "a stringtable with this name already exists";
+	else if( stcinternal->GetNumTables( ) >= MAX_TABLES )
+		error = "too many stringtables";
+
+	if( error != nullptr )
+	{
+		LUA->PushNil( );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	const bool allow_creation = stcinternal->m_bAllowCreation;
+	const bool locked = stcinternal->Lock( false );
+	stcinternal->m_bAllowCreation = true;
+	INetworkStringTable *stable = stcinternal->CreateStringTableEx( name, maxentries, 0, 0, is_filenames );
+	stcinternal->m_bAllowCreation = allow_creation;
+	stcinternal->Lock( locked );
+
+	InvalidateNameIndex( );
+	stringtable::Push( LUA, static_cast<CNetworkStringTable *>( stable ) );
+	return 1;
+}
+
 LUA_FUNCTION_STATIC( Lock )
 {
 	LUA->PushBool( stcinternal->Lock( LUA->GetBool( 1 ) ) );
@@ -61,7 +184,123 @@ LUA_FUNCTION_STATIC( Lock )
 
 LUA_FUNCTION_STATIC( Dump )
 {
-	stcinternal->Dump( );
+	if( LUA->IsType( 1, GarrysMod::Lua::Type::NONE ) || LUA->IsType( 1, GarrysMod::Lua::Type::NIL ) )
+	{
+		stcinternal->Dump( );
+		return 0;
+	}
+
+	const char *path = LUA->CheckString( 1 );
+
+	std::vector<CNetworkStringTable *> stringtables;
+	for( int32_t i = 0; i < stcinternal->GetNumTables( ); ++i )
+	{
+		CNetworkStringTable *stable = static_cast<CNetworkStringTable *>( stcinternal->GetTable( i ) );
+		if( stable != nullptr )
+			stringtables.push_back( stable );
+	}
+
+	const char *error = dumpfile::Start( LUA, path, stringtables, 2 );
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( Snapshot )
+{
+	const char *path = LUA->CheckString( 1 );
+
+	std::vector<CNetworkStringTable *> stringtables;
+	for( int32_t i = 0; i < stcinternal->GetNumTables( ); ++i )
+		stringtables.push_back( static_cast<CNetworkStringTable *>( stcinternal->GetTable( i ) ) );
+
+	const char *error = stringtablefile::Write( path, stringtables.data( ), stringtables.size( ) );
+	if( error != nullptr )
+	{
+		LUA->PushBool( false );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushBool( true );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( Restore )
+{
+	const char *path = LUA->CheckString( 1 );
+	const bool is_server = stringtable::GetRealmArgument( LUA, 2 );
+
+	std::vector<CNetworkStringTable *> restored_tables;
+	int32_t restored = 0;
+	const char *error = stringtablefile::Read( path, is_server, [LUA, &restored_tables]( const char *name )
+	{
+		CachedTable *entry = FindCachedTable( name );
+		if( entry == nullptr )
+			return static_cast<CNetworkStringTable *>( nullptr );
+
+		batch::Flush( LUA, entry->stringtable );
+		restored_tables.push_back( entry->stringtable );
+		return entry->stringtable;
+	}, restored );
+
+	for( CNetworkStringTable *stable : restored_tables )
+		stringtable::Invalidate( LUA, stable );
+
+	if( error != nullptr )
+	{
+		LUA->PushNil( );
+		LUA->PushString( error );
+		return 2;
+	}
+
+	LUA->PushNumber( restored );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetMemoryUsage )
+{
+	memoryusage::Usage total;
+
+	LUA->CreateTable( );
+	for( int32_t i = 0; i < stcinternal->GetNumTables( ); ++i )
+	{
+		CNetworkStringTable *stable = static_cast<CNetworkStringTable *>( stcinternal->GetTable( i ) );
+		const memoryusage::Usage usage = memoryusage::Get( stable );
+		total += usage;
+
+		LUA->PushNumber( static_cast<double>( usage.Total( ) ) );
+		LUA->SetField( -2, stable->GetTableName( ) );
+	}
+
+	memoryusage::Push( LUA, total );
+	LUA->Push( -2 );
+	LUA->SetField( -2, "tables" );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( EnableStats )
+{
+	LUA->CheckType( 1, GarrysMod::Lua::Type::BOOL );
+	stats::Enable( LUA->GetBool( 1 ) );
+	return 0;
+}
+
+LUA_FUNCTION_STATIC( GetStats )
+{
+	stats::Push( LUA );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( ResetStats )
+{
+	stats::Reset( );
 	return 0;
 }
 
@@ -94,29 +333,52 @@ void Initialize( GarrysMod::Lua::ILuaBase *LUA )
 	LUA->PushNumber( 10103 );
 	LUA->SetField( -2, "VersionNum" );
 
-	LUA->PushCFunction( Find );
+	stats::PushCFunction( LUA, Find, "stringtable.Find" );
 	LUA->SetField( -2, "Find" );
 
-	LUA->PushCFunction( Get );
+	stats::PushCFunction( LUA, Get, "stringtable.Get" );
 	LUA->SetField( -2, "Get" );
 
-	LUA->PushCFunction( GetCount );
+	stats::PushCFunction( LUA, GetCount, "stringtable.GetCount" );
 	LUA->SetField( -2, "GetCount" );
 
-	LUA->PushCFunction( Lock );
+	stats::PushCFunction( LUA, Create, "stringtable.Create" );
+	LUA->SetField( -2, "Create" );
+
+	stats::PushCFunction( LUA, Lock, "stringtable.Lock" );
 	LUA->SetField( -2, "Lock" );
 
-	LUA->PushCFunction( Dump );
+	stats::PushCFunction( LUA, Dump, "stringtable.Dump" );
 	LUA->SetField( -2, "Dump" );
 
-	LUA->PushCFunction( GetNames );
+	stats::PushCFunction( LUA, GetNames, "stringtable.GetNames" );
 	LUA->SetField( -2, "GetNames" );
 
+	stats::PushCFunction( LUA, GetMemoryUsage, "stringtable.GetMemoryUsage" );
+	LUA->SetField( -2, "GetMemoryUsage" );
+
+	LUA->PushCFunction( EnableStats );
+	LUA->SetField( -2, "EnableStats" );
+
+	LUA->PushCFunction( GetStats );
+	LUA->SetField( -2, "GetStats" );
+
+	LUA->PushCFunction( ResetStats );
+	LUA->SetField( -2, "ResetStats" );
+
+	stats::PushCFunction( LUA, Snapshot, "stringtable.Snapshot" );
+	LUA->SetField( -2, "Snapshot" );
+
+	stats::PushCFunction( LUA, Restore, "stringtable.Restore" );
+	LUA->SetField( -2, "Restore" );
+
 	LUA->SetField( GarrysMod::Lua::INDEX_GLOBAL, table_name );
 }
 
 void Deinitialize( GarrysMod::Lua::ILuaBase *LUA )
 {
+	ClearNameIndex( );
+
 	LUA->PushNil( );
 	LUA->SetField( GarrysMod::Lua::INDEX_GLOBAL, table_name );
 }
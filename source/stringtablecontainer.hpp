@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+
 class CNetworkStringTableContainer;
+class INetworkStringTable;
 
 namespace GarrysMod
 {
@@ -17,5 +20,10 @@ extern CNetworkStringTableContainer *stcinternal;
 
 void Initialize( GarrysMod::Lua::ILuaBase *LUA );
 void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
+void InvalidateNameIndex( );
+
+// Whether the engine still holds stringtable at id. Tables are freed on level change and
+// their replacements can reuse the same address, so a pointer alone can't tell.
+bool IsAlive( const INetworkStringTable *stringtable, int32_t id );
 
 }
@@ -0,0 +1,229 @@
+#include "stringtablefile.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/InterfacePointers.hpp>
+#include <filesystem.h>
+
+#include <cstring>
+#include <vector>
+
+namespace stringtablefile
+{
+
+static const char magic[4] = { 'G', 'M', 'S', 'T' };
+static const uint32_t version = 1;
+static const char path_id[] = "DATA";
+
+class Writer
+{
+public:
+	template<typename T>
+	void Put( T value )
+	{
+		Put( &value, sizeof( value ) );
+	}
+
+	void Put( const void *data, size_t size )
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>( data );
+		buffer.insert( buffer.end( ), bytes, bytes + size );
+	}
+
+	void PutString( const char *str )
+	{
+		const size_t len = std::strlen( str );
+		Put( static_cast<uint16_t>( len ) );
+		Put( str, len + 1 );
+	}
+
+	std::vector<uint8_t> buffer;
+};
+
+class Reader
+{
+public:
+	Reader( const uint8_t *data, size_t size ) :
+		current( data ), end( data + size )
+	{ }
+
+	template<typename T>
+	bool Get( T &value )
+	{
+		if( static_cast<size_t>( end - current ) < sizeof( value ) )
+			return false;
+
+		std::memcpy( &value, current, sizeof( value ) );
+		current += sizeof( value );
+		return true;
+	}
+
+	// Returns a pointer into the buffer, avoiding any copies
+	const uint8_t *Skip( size_t size )
+	{
+		if( static_cast<size_t>( end - current ) < size )
+			return nullptr;
+
+		const uint8_t *data = current;
+		current += size;
+		return data;
+	}
+
+	const char *GetString( )
+	{
+		uint16_t len = 0;
+		if( !Get( len ) )
+			return nullptr;
+
+		const char *str = reinterpret_cast<const char *>( Skip( len + 1u ) );
+		return str != nullptr && str[len] == '\0' ? str : nullptr;
+	}
+
+private:
+	const uint8_t *current;
+	const uint8_t *end;
+};
+
+bool IsValidPath( const char *path )
+{
+	return path[0] != '\0' && path[0] != '/' && path[0] != '\\' &&
+		std::strstr( path, ".." ) == nullptr && std::strchr( path, ':' ) == nullptr;
+}
+
+bool ReadFile( const char *path, std::vector<uint8_t> &buffer )
+{
+	IFileSystem *filesystem = InterfacePointers::FileSystem( );
+	if( filesystem == nullptr || !IsValidPath( path ) )
+		return false;
+
+	FileHandle_t file = filesystem->Open( path, "rb", path_id );
+	if( file == FILESYSTEM_INVALID_HANDLE )
+		return false;
+
+	buffer.resize( filesystem->Size( file ) );
+	const int32_t size = static_cast<int32_t>( buffer.size( ) );
+	const bool read = filesystem->Read( buffer.data( ), size, file ) == size;
+	filesystem->Close( file );
+	return read;
+}
+
+static void WriteTable( Writer &writer, CNetworkStringTable *stable )
+{
+	writer.PutString( stable->GetTableName( ) );
+
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr )
+	{
+		writer.Put( static_cast<uint32_t>( 0 ) );
+		return;
+	}
+
+	CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	const int32_t count = dict.Count( );
+	writer.Put( static_cast<uint32_t>( count ) );
+	for( int32_t i = 0; i < count; ++i )
+	{
+		writer.PutString( dict.Key( i ) );
+
+		const CNetworkStringTableItem &item = dict.Element( i );
+		const uint16_t len = item.m_pUserData != nullptr ? static_cast<uint16_t>( item.m_nUserDataLength ) : 0;
+		writer.Put( len );
+		writer.Put( item.m_pUserData, len );
+	}
+}
+
+const char *Write( const char *path, CNetworkStringTable *const *stringtables, size_t count )
+{
+	if( !IsValidPath( path ) )
+		return "invalid path";
+
+	IFileSystem *filesystem = InterfacePointers::FileSystem( );
+	if( filesystem == nullptr )
+		return "filesystem unavailable";
+
+	Writer writer;
+	writer.Put( magic, sizeof( magic ) );
+	writer.Put( version );
+	writer.Put( static_cast<uint32_t>( count ) );
+	for( size_t k = 0; k < count; ++k )
+		WriteTable( writer, stringtables[k] );
+
+	FileHandle_t file = filesystem->Open( path, "wb", path_id );
+	if( file == FILESYSTEM_INVALID_HANDLE )
+		return "unable to open file for writing";
+
+	const int32_t size = static_cast<int32_t>( writer.buffer.size( ) );
+	const bool written = filesystem->Write( writer.buffer.data( ), size, file ) == size;
+	filesystem->Close( file );
+	return written ? nullptr : "unable to write file";
+}
+
+static const char *ReadTable( Reader &reader, bool is_server, CNetworkStringTable *stable, int32_t &restored )
+{
+	uint32_t count = 0;
+	if( !reader.Get( count ) )
+		return "truncated file";
+
+	for( uint32_t k = 0; k < count; ++k )
+	{
+		const char *str = reader.GetString( );
+		uint16_t len = 0;
+		if( str == nullptr || !reader.Get( len ) )
+			return "truncated file";
+
+		const uint8_t *userdata = reader.Skip( len );
+		if( userdata == nullptr )
+			return "truncated file";
+
+		if( stable == nullptr )
+			continue;
+
+		// AddString updates the userdata of strings that already exist
+		const int32_t index = len != 0 ?
+			stable->AddString( is_server, str, len, userdata ) :
+			stable->AddString( is_server, str );
+		if( index != INVALID_STRING_INDEX )
+			++restored;
+	}
+
+	return nullptr;
+}
+
+const char *Read(
+	const char *path,
+	bool is_server,
+	const std::function<CNetworkStringTable *( const char *name )> &resolve,
+	int32_t &restored
+)
+{
+	restored = 0;
+
+	if( !IsValidPath( path ) )
+		return "invalid path";
+
+	std::vector<uint8_t> buffer;
+	if( !ReadFile( path, buffer ) )
+		return "unable to read file";
+
+	Reader reader( buffer.data( ), buffer.size( ) );
+
+	const uint8_t *header = reader.Skip( sizeof( magic ) );
+	uint32_t file_version = 0, count = 0;
+	if( header == nullptr || std::memcmp( header, magic, sizeof( magic ) ) != 0 ||
+		!reader.Get( file_version ) || file_version != version || !reader.Get( count ) )
+		return "not a stringtable snapshot";
+
+	for( uint32_t k = 0; k < count; ++k )
+	{
+		const char *name = reader.GetString( );
+		if( name == nullptr )
+			return "truncated file";
+
+		const char *error = ReadTable( reader, is_server, resolve( name ), restored );
+		if( error != nullptr )
+			return error;
+	}
+
+	return nullptr;
+}
+
+}
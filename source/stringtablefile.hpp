@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class CNetworkStringTable;
+
+namespace stringtablefile
+{
+
+// Paths are relative to the DATA path and can't escape it
+bool IsValidPath( const char *path );
+// Safe to call from worker threads
+bool ReadFile( const char *path, std::vector<uint8_t> &buffer );
+
+// Both return nullptr on success or a static error message.
+// Files are relative to the DATA path and use this layout, little endian:
+//   "GMST", uint32 version, uint32 table count, then per table:
+//   uint16 name length, name, '\0', uint32 entry count, then per entry:
+//   uint16 string length, string, '\0', uint16 userdata length, userdata
+// Userdata is stored as the table holds it, still encoded for tables using the codec.
+const char *Write( const char *path, CNetworkStringTable *const *stringtables, size_t count );
+const char *Read(
+	const char *path,
+	bool is_server,
+	const std::function<CNetworkStringTable *( const char *name )> &resolve,
+	int32_t &restored
+);
+
+}
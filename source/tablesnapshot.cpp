@@ -0,0 +1,315 @@
+#include "tablesnapshot.hpp"
+#include "codec.hpp"
+#include "stats.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <lua.hpp>
+
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace tablesnapshot
+{
+
+static const uint32_t no_userdata = UINT32_MAX;
+
+Snapshot *Snapshot::Create( CNetworkStringTable *stable )
+{
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	const int32_t count = networkdict != nullptr ? networkdict->Count( ) : 0;
+	const char *table_name = stable->GetTableName( );
+
+	// snapshots hold userdata as it was written, encoded tables are decoded up front
+	std::vector<std::string> decoded( codec::IsEnabled( stable ) ? count : 0 );
+	std::vector<const void *> userdata( count, nullptr );
+	std::vector<int32_t> userdata_length( count, 0 );
+	for( int32_t i = 0; i < count; ++i )
+	{
+		if( decoded.empty( ) )
+		{
+			const CNetworkStringTableItem &item = networkdict->m_Items.Element( i );
+			userdata[i] = item.m_pUserData;
+			userdata_length[i] = item.m_nUserDataLength;
+		}
+		else
+		{
+			userdata[i] = codec::GetStringUserData( stable, i, userdata_length[i], decoded[i] );
+		}
+	}
+
+	// size everything first so the whole snapshot is one allocation
+	size_t data_size = std::strlen( table_name ) + 1;
+	for( int32_t i = 0; i < count; ++i )
+	{
+		data_size += std::strlen( networkdict->m_Items.Key( i ) ) + 1;
+		if( userdata[i] != nullptr )
+			data_size += static_cast<size_t>( userdata_length[i] );
+	}
+
+	void *memory = ::operator new( sizeof( Snapshot ) + sizeof( Entry ) * count + data_size );
+	Snapshot *snapshot = new( memory ) Snapshot;
+	snapshot->references = 1;
+	snapshot->count = count;
+	snapshot->tick = stable->m_nTickCount;
+
+	Entry *entries = const_cast<Entry *>( snapshot->GetEntries( ) );
+	char *data = const_cast<char *>( snapshot->GetData( ) );
+	uint32_t offset = 0;
+	auto append = [data, &offset]( const void *source, size_t length )
+	{
+		const uint32_t start = offset;
+		std::memcpy( data + offset, source, length );
+		offset += static_cast<uint32_t>( length );
+		return start;
+	};
+
+	snapshot->name = append( table_name, std::strlen( table_name ) + 1 );
+	for( int32_t i = 0; i < count; ++i )
+	{
+		const char *str = networkdict->m_Items.Key( i );
+		Entry &entry = entries[i];
+
+		entry.string_length = static_cast<uint32_t>( std::strlen( str ) );
+		entry.string = append( str, entry.string_length + 1 );
+
+		if( userdata[i] != nullptr )
+		{
+			entry.userdata_length = static_cast<uint32_t>( userdata_length[i] );
+			entry.userdata = append( userdata[i], entry.userdata_length );
+		}
+		else
+		{
+			entry.userdata_length = 0;
+			entry.userdata = no_userdata;
+		}
+	}
+
+	return snapshot;
+}
+
+void Snapshot::AddRef( ) const
+{
+	references.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void Snapshot::Release( ) const
+{
+	if( references.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+		return;
+
+	this->~Snapshot( );
+	::operator delete( const_cast<Snapshot *>( this ) );
+}
+
+int32_t Snapshot::GetCount( ) const
+{
+	return count;
+}
+
+int32_t Snapshot::GetTick( ) const
+{
+	return tick;
+}
+
+const char *Snapshot::GetName( ) const
+{
+	return GetData( ) + name;
+}
+
+const char *Snapshot::GetString( int32_t index, int32_t *length ) const
+{
+	if( index < 0 || index >= count )
+		return nullptr;
+
+	const Entry &entry = GetEntries( )[index];
+	if( length != nullptr )
+		*length = static_cast<int32_t>( entry.string_length );
+
+	return GetData( ) + entry.string;
+}
+
+const void *Snapshot::GetUserData( int32_t index, int32_t *length ) const
+{
+	if( index < 0 || index >= count )
+		return nullptr;
+
+	const Entry &entry = GetEntries( )[index];
+	if( length != nullptr )
+		*length = static_cast<int32_t>( entry.userdata_length );
+
+	return entry.userdata != no_userdata ? GetData( ) + entry.userdata : nullptr;
+}
+
+const Snapshot::Entry *Snapshot::GetEntries( ) const
+{
+	return reinterpret_cast<const Entry *>( this + 1 );
+}
+
+const char *Snapshot::GetData( ) const
+{
+	return reinterpret_cast<const char *>( GetEntries( ) + count );
+}
+
+struct Container
+{
+	Snapshot *snapshot;
+};
+
+static const char metaname[] = "stringtable_snapshot";
+static int32_t metatype = GarrysMod::Lua::Type::NONE;
+static const char invalid_error[] = "invalid stringtable snapshot";
+
+static Snapshot *Get( GarrysMod::Lua::ILuaBase *LUA, int32_t index )
+{
+	if( !LUA->IsType( index, metatype ) )
+		luaL_typerror( LUA->GetState( ), index, metaname );
+
+	Container *udata = LUA->GetUserType<Container>( index, metatype );
+	if( udata == nullptr || udata->snapshot == nullptr )
+		LUA->ArgError( index, invalid_error );
+
+	return udata->snapshot;
+}
+
+void Push( GarrysMod::Lua::ILuaBase *LUA, Snapshot *snapshot )
+{
+	Container *udata = LUA->NewUserType<Container>( metatype );
+	udata->snapshot = snapshot;
+
+	LUA->PushMetaTable( metatype );
+	LUA->SetMetaTable( -2 );
+}
+
+LUA_FUNCTION_STATIC( gc )
+{
+	if( !LUA->IsType( 1, metatype ) )
+		return 0;
+
+	Container *udata = LUA->GetUserType<Container>( 1, metatype );
+	if( udata == nullptr || udata->snapshot == nullptr )
+		return 0;
+
+	udata->snapshot->Release( );
+	udata->snapshot = nullptr;
+	LUA->SetUserType( 1, nullptr );
+	return 0;
+}
+
+LUA_FUNCTION_STATIC( tostring )
+{
+	lua_pushfstring( LUA->GetState( ), "%s: %p", metaname, Get( LUA, 1 ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetName )
+{
+	LUA->PushString( Get( LUA, 1 )->GetName( ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetTick )
+{
+	LUA->PushNumber( Get( LUA, 1 )->GetTick( ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetNumStrings )
+{
+	LUA->PushNumber( Get( LUA, 1 )->GetCount( ) );
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetString )
+{
+	const Snapshot *snapshot = Get( LUA, 1 );
+	const int32_t index = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+
+	int32_t length = 0;
+	const char *str = snapshot->GetString( index, &length );
+	if( str != nullptr )
+		LUA->PushString( str, static_cast<unsigned int>( length ) );
+	else
+		LUA->PushNil( );
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetStringUserData )
+{
+	const Snapshot *snapshot = Get( LUA, 1 );
+	const int32_t index = static_cast<int32_t>( LUA->CheckNumber( 2 ) );
+
+	int32_t length = 0;
+	const void *userdata = snapshot->GetUserData( index, &length );
+	if( userdata != nullptr )
+		LUA->PushString( static_cast<const char *>( userdata ), static_cast<unsigned int>( length ) );
+	else
+		LUA->PushNil( );
+
+	return 1;
+}
+
+LUA_FUNCTION_STATIC( GetHandle )
+{
+	// stringtable_snapshot_t * for stringtableapi.h, only valid while this object is alive
+	// unless the C side takes its own reference
+	LUA->PushUserdata( Get( LUA, 1 ) );
+	return 1;
+}
+
+void Initialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	metatype = LUA->CreateMetaTable( metaname );
+
+	LUA->PushCFunction( gc );
+	LUA->SetField( -2, "__gc" );
+
+	LUA->PushCFunction( tostring );
+	LUA->SetField( -2, "__tostring" );
+
+	LUA->Push( -1 );
+	LUA->SetField( -2, "__index" );
+
+	stats::PushCFunction( LUA, GetName, "stringtable_snapshot:GetName" );
+	LUA->SetField( -2, "GetName" );
+
+	stats::PushCFunction( LUA, GetTick, "stringtable_snapshot:GetTick" );
+	LUA->SetField( -2, "GetTick" );
+
+	stats::PushCFunction( LUA, GetNumStrings, "stringtable_snapshot:GetNumStrings" );
+	LUA->SetField( -2, "GetNumStrings" );
+
+	stats::PushCFunction( LUA, GetString, "stringtable_snapshot:GetString" );
+	LUA->SetField( -2, "GetString" );
+
+	stats::PushCFunction( LUA, GetStringUserData, "stringtable_snapshot:GetStringUserData" );
+	LUA->SetField( -2, "GetStringUserData" );
+
+	stats::PushCFunction( LUA, GetHandle, "stringtable_snapshot:GetHandle" );
+	LUA->SetField( -2, "GetHandle" );
+
+	LUA->Pop( 1 );
+}
+
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	// objects outlive the module, keep their metatable from calling back into it
+	if( LUA->PushMetaTable( metatype ) )
+	{
+		LUA->PushNil( );
+		LUA->SetField( -2, "__gc" );
+		LUA->PushNil( );
+		LUA->SetField( -2, "__tostring" );
+		LUA->PushNil( );
+		LUA->SetField( -2, "__index" );
+		LUA->Pop( 1 );
+	}
+
+	LUA->PushNil( );
+	LUA->SetField( GarrysMod::Lua::INDEX_REGISTRY, metaname );
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+class CNetworkStringTable;
+
+namespace tablesnapshot
+{
+
+// Read-only copy of a stringtable in a single allocation (entry offsets followed by the
+// strings and userdata). Only Create touches the engine, everything else can be used from
+// any thread while the live table keeps changing.
+class Snapshot
+{
+public:
+	// Main thread only, the snapshot starts with one reference
+	static Snapshot *Create( CNetworkStringTable *stringtable );
+
+	void AddRef( ) const;
+	void Release( ) const;
+
+	int32_t GetCount( ) const;
+	int32_t GetTick( ) const;
+	const char *GetName( ) const;
+
+	// Both return nullptr for invalid indices, length is optional
+	const char *GetString( int32_t index, int32_t *length ) const;
+	const void *GetUserData( int32_t index, int32_t *length ) const;
+
+private:
+	struct Entry
+	{
+		uint32_t string;
+		uint32_t string_length;
+		uint32_t userdata;
+		uint32_t userdata_length;
+	};
+
+	Snapshot( ) = default;
+	~Snapshot( ) = default;
+
+	const Entry *GetEntries( ) const;
+	const char *GetData( ) const;
+
+	mutable std::atomic<int32_t> references;
+	int32_t count;
+	int32_t tick;
+	uint32_t name;
+};
+
+void Initialize( GarrysMod::Lua::ILuaBase *LUA );
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
+// Pushes a Lua object that takes over one reference of the snapshot
+void Push( GarrysMod::Lua::ILuaBase *LUA, Snapshot *snapshot );
+
+}
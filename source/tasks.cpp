@@ -0,0 +1,85 @@
+#include "tasks.hpp"
+
+#include <GarrysMod/Lua/Interface.h>
+#include <tier0/dbg.h>
+
+#include <memory>
+#include <vector>
+
+namespace tasks
+{
+
+static const char hook_name[] = "stringtable.tasks";
+
+static std::vector<std::unique_ptr<Task>> active;
+static GarrysMod::Lua::ILuaBase *lua = nullptr;
+static bool hooked = false;
+
+LUA_FUNCTION_STATIC( Think )
+{
+	// tasks can add other tasks from their callbacks, so don't hold iterators
+	for( size_t k = 0; k < active.size( ); )
+		if( active[k]->Think( LUA ) )
+			++k;
+		else
+			active.erase( active.begin( ) + k );
+
+	return 0;
+}
+
+static bool CallHook( GarrysMod::Lua::ILuaBase *LUA, const char *function, bool add )
+{
+	LUA->GetField( GarrysMod::Lua::INDEX_GLOBAL, "hook" );
+	if( !LUA->IsType( -1, GarrysMod::Lua::Type::TABLE ) )
+	{
+		LUA->Pop( 1 );
+		return false;
+	}
+
+	LUA->GetField( -1, function );
+	LUA->PushString( "Think" );
+	LUA->PushString( hook_name );
+	if( add )
+		LUA->PushCFunction( Think );
+
+	LUA->Call( add ? 3 : 2, 0 );
+	LUA->Pop( 1 );
+	return true;
+}
+
+void Initialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	// the Think hook is only added with the first task, the hook library may not be loaded yet
+	lua = LUA;
+}
+
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA )
+{
+	if( hooked )
+		CallHook( LUA, "Remove", false );
+
+	hooked = false;
+	active.clear( );
+	lua = nullptr;
+}
+
+void Add( Task *task )
+{
+	active.emplace_back( task );
+
+	// retried with every task until the hook library shows up, queued tasks wait until then
+	if( !hooked && lua != nullptr && !( hooked = CallHook( lua, "Add", true ) ) )
+		Warning( "[stringtable] hook library unavailable, background tasks are delayed\n" );
+}
+
+bool Call( GarrysMod::Lua::ILuaBase *LUA, int32_t args )
+{
+	if( LUA->PCall( args, 0, 0 ) == 0 )
+		return true;
+
+	Warning( "[stringtable] %s\n", LUA->GetString( -1 ) );
+	LUA->Pop( 1 );
+	return false;
+}
+
+}
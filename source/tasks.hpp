@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace GarrysMod
+{
+	namespace Lua
+	{
+		class ILuaBase;
+	}
+}
+
+namespace tasks
+{
+
+class Task
+{
+public:
+	virtual ~Task( ) = default;
+
+	// Called once per frame on the main thread, returns false once the task is finished
+	virtual bool Think( GarrysMod::Lua::ILuaBase *LUA ) = 0;
+};
+
+void Initialize( GarrysMod::Lua::ILuaBase *LUA );
+void Deinitialize( GarrysMod::Lua::ILuaBase *LUA );
+
+// Takes ownership of the task. Main thread only, the first task adds the Think hook.
+void Add( Task *task );
+
+// Calls the function below its arguments on the stack, printing errors instead of propagating them
+bool Call( GarrysMod::Lua::ILuaBase *LUA, int32_t args );
+
+}
@@ -0,0 +1,110 @@
+#include "updatesize.hpp"
+#include "hackednetworkstringtable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <string>
+
+namespace updatesize
+{
+
+// Encoding constants from networkstringtable.cpp and netmessages.cpp
+static const int32_t substring_bits = 5;
+static const size_t max_history = 32;
+static const int32_t history_index_bits = 5;
+static const int32_t message_type_bits = 6;
+static const int32_t table_id_bits = 5;
+static const int32_t message_length_bits = 20;
+
+// Same as the engine's CountSimilarCharacters, capped by what substring_bits can encode
+static int32_t CountSimilarCharacters( const char *str1, const char *str2 )
+{
+	int32_t count = 0;
+	while( *str1 != '\0' && *str2 != '\0' && *str1 == *str2 && count < ( 1 << substring_bits ) - 1 )
+	{
+		++str1;
+		++str2;
+		++count;
+	}
+
+	return count;
+}
+
+static int32_t GetBestPreviousString( const std::deque<std::string> &history, const char *str )
+{
+	int32_t best_count = 0;
+	for( const std::string &previous : history )
+	{
+		const int32_t similar = CountSimilarCharacters( str, previous.c_str( ) );
+		if( similar >= 3 && similar > best_count )
+			best_count = similar;
+	}
+
+	return best_count;
+}
+
+Estimate Get( CNetworkStringTable *stable, int32_t tick )
+{
+	Estimate estimate;
+
+	CNetworkStringDict *networkdict = stable->m_pItems;
+	if( networkdict == nullptr || !stable->ChangedSinceTick( tick ) )
+		return estimate;
+
+	const CNetworkStringDict::StableHashtable_t &dict = networkdict->m_Items;
+	std::deque<std::string> history;
+	int32_t last_entry = -1;
+	for( int32_t i = 0; i < dict.Count( ); ++i )
+	{
+		const CNetworkStringTableItem &item = dict.Element( i );
+		if( item.GetTickChanged( ) <= tick )
+			continue;
+
+		// entry index, a single bit when it follows the previous one
+		estimate.bits += last_entry + 1 == i ? 1 : 1 + stable->m_nEntryBits;
+
+		const char *str = dict.Key( i );
+		estimate.bits += 1;
+		if( item.GetTickCreated( ) > tick )
+		{
+			// the string is sent, prefixed by how much of a recent string it reuses
+			const int32_t substring = GetBestPreviousString( history, str );
+			estimate.bits += 1;
+			if( substring != 0 )
+				estimate.bits += history_index_bits + substring_bits;
+
+			estimate.bits += ( std::strlen( str + substring ) + 1 ) * 8;
+		}
+
+		const int32_t length = item.m_nUserDataLength;
+		estimate.bits += 1;
+		if( item.m_pUserData != nullptr && length > 0 )
+		{
+			if( stable->m_bUserDataFixedSize )
+				estimate.bits += stable->m_nUserDataSizeBits;
+			else
+				estimate.bits += CNetworkStringTableItem::MAX_USERDATA_BITS + length * 8;
+		}
+
+		// the engine keeps the first 31 characters of the last 32 strings
+		if( history.size( ) == max_history )
+			history.pop_front( );
+
+		history.emplace_back( str, std::min<size_t>( std::strlen( str ), max_history - 1 ) );
+
+		++estimate.entries;
+		last_entry = i;
+	}
+
+	if( estimate.entries != 0 )
+	{
+		// single changed entry is flagged by one bit, otherwise the count follows as a word
+		const int32_t count_bits = estimate.entries == 1 ? 1 : 1 + 16;
+		estimate.message_bits = message_type_bits + table_id_bits + count_bits + message_length_bits + estimate.bits;
+	}
+
+	return estimate;
+}
+
+}
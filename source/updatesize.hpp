@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+class CNetworkStringTable;
+
+namespace updatesize
+{
+
+struct Estimate
+{
+	int32_t entries = 0;
+	// bits WriteUpdate would write for the entries
+	int64_t bits = 0;
+	// bits of the svc_UpdateStringTable message carrying them, header included
+	int64_t message_bits = 0;
+};
+
+// Replays the encoding of CNetworkStringTable::WriteUpdate for a client that acknowledged tick
+Estimate Get( CNetworkStringTable *stringtable, int32_t tick );
+
+}